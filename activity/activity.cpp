@@ -0,0 +1,202 @@
+#include "activity.hpp"
+#include "../rpc/rpc.hpp"
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+std::string to_hex_quantity(uint64_t value) {
+    std::ostringstream ss;
+    ss << "0x" << std::hex << value;
+    return ss.str();
+}
+
+struct AccountState {
+    uint64_t nonce;
+    Uint256 balance;
+
+    bool active() const { return nonce > 0 || !balance.is_zero(); }
+    bool operator==(const AccountState& o) const { return nonce == o.nonce && balance == o.balance; }
+};
+
+// One bound of the k-ary search. The answer lies in (lo, hi]:
+// the predicate is false at lo (or lo is -1) and true at hi.
+struct Bound {
+    int64_t lo;
+    int64_t hi;
+
+    bool done() const { return hi - lo <= 1; }
+};
+
+// Split (lo, hi) into fanout intervals and return the inner points, ascending
+std::vector<uint64_t> probe_points(const Bound& b, size_t fanout) {
+    std::vector<uint64_t> points;
+    if (b.done()) return points;
+
+    __int128 span = b.hi - b.lo;
+    for (size_t i = 1; i < fanout; i++) {
+        int64_t p = b.lo + static_cast<int64_t>(span * i / fanout);
+        if (p > b.lo && p < b.hi && (points.empty() || p > static_cast<int64_t>(points.back()))) {
+            points.push_back(static_cast<uint64_t>(p));
+        }
+    }
+    return points;
+}
+
+// Move the bound to the first interval where the predicate flips
+void narrow(Bound& b, const std::vector<uint64_t>& points, const std::vector<bool>& pred) {
+    for (size_t i = 0; i < points.size(); i++) {
+        if (pred[i]) {
+            b.hi = static_cast<int64_t>(points[i]);
+            return;
+        }
+        b.lo = static_cast<int64_t>(points[i]);
+    }
+}
+
+void add_state_calls(std::vector<RpcCall>& calls, const std::string& address, const std::string& block) {
+    calls.push_back({"eth_getTransactionCount", json::array({address, block})});
+    calls.push_back({"eth_getBalance", json::array({address, block})});
+}
+
+// Read the (nonce, balance) pair starting at results[offset]
+std::optional<AccountState> read_state(const std::vector<std::optional<json>>& results, size_t offset) {
+    const auto& nonce = results[offset];
+    const auto& balance = results[offset + 1];
+    if (!nonce || !balance || !nonce->is_string() || !balance->is_string()) {
+        return std::nullopt;
+    }
+
+    auto value = Uint256::from_hex(balance->get_ref<const std::string&>());
+    if (!value) {
+        return std::nullopt;
+    }
+    return AccountState{RpcClient::hex_to_uint64(nonce->get_ref<const std::string&>()), *value};
+}
+
+// Fetch the timestamps of distinct blocks in one batch (0 where unknown)
+std::optional<std::vector<uint64_t>> fetch_timestamps(const std::string& rpc_url,
+                                                      const std::vector<uint64_t>& blocks,
+                                                      size_t& round_trips) {
+    std::vector<RpcCall> calls;
+    for (uint64_t b : blocks) {
+        calls.push_back({"eth_getBlockByNumber", json::array({to_hex_quantity(b), false})});
+    }
+
+    auto results = RpcClient::batch_call(rpc_url, calls);
+    round_trips++;
+    if (results.empty()) return std::nullopt;
+
+    std::vector<uint64_t> timestamps(blocks.size(), 0);
+    for (size_t i = 0; i < blocks.size(); i++) {
+        const auto& block = results[i];
+        if (block && block->is_object() && block->contains("timestamp") && (*block)["timestamp"].is_string()) {
+            timestamps[i] = RpcClient::hex_to_uint64((*block)["timestamp"].get_ref<const std::string&>());
+        }
+    }
+    return timestamps;
+}
+
+} // anonymous namespace
+
+namespace ActivityFinder {
+
+std::optional<ActivityRange> find_range(const std::string& rpc_url,
+                                        const std::string& address,
+                                        size_t fanout) {
+    if (fanout < 2) fanout = 2;
+
+    ActivityRange range{};
+
+    // Pin the chain head and read the current state in one request
+    std::vector<RpcCall> calls;
+    calls.push_back({"eth_blockNumber", json::array()});
+    add_state_calls(calls, address, "latest");
+
+    auto results = RpcClient::batch_call(rpc_url, calls);
+    range.round_trips++;
+    if (results.empty() || !results[0] || !results[0]->is_string()) {
+        return std::nullopt;
+    }
+
+    auto current = read_state(results, 1);
+    if (!current) {
+        return std::nullopt;
+    }
+
+    range.latest_block = RpcClient::hex_to_uint64(results[0]->get_ref<const std::string&>());
+    range.has_activity = current->active();
+    if (!range.has_activity) {
+        return range;
+    }
+
+    // first: earliest block where the account is active
+    // last: earliest block where the account already has its current state
+    Bound first{-1, static_cast<int64_t>(range.latest_block)};
+    Bound last{-1, static_cast<int64_t>(range.latest_block)};
+
+    while (!first.done() || !last.done()) {
+        // The current state is active, so the bounds constrain each other
+        last.lo = std::max(last.lo, first.lo);
+        first.hi = std::min(first.hi, last.hi);
+
+        auto first_points = probe_points(first, fanout);
+        auto last_points = probe_points(last, fanout);
+        if (first_points.empty() && last_points.empty()) break;
+
+        calls.clear();
+        for (uint64_t p : first_points) add_state_calls(calls, address, to_hex_quantity(p));
+        for (uint64_t p : last_points) add_state_calls(calls, address, to_hex_quantity(p));
+
+        results = RpcClient::batch_call(rpc_url, calls);
+        range.round_trips++;
+        if (results.empty()) {
+            return std::nullopt;
+        }
+
+        std::vector<bool> first_pred;
+        std::vector<bool> last_pred;
+        size_t offset = 0;
+
+        for (size_t i = 0; i < first_points.size(); i++, offset += 2) {
+            auto state = read_state(results, offset);
+            if (!state) return std::nullopt;  // no historical state on this endpoint
+            first_pred.push_back(state->active());
+        }
+        for (size_t i = 0; i < last_points.size(); i++, offset += 2) {
+            auto state = read_state(results, offset);
+            if (!state) return std::nullopt;
+            last_pred.push_back(*state == *current);
+        }
+
+        narrow(first, first_points, first_pred);
+        narrow(last, last_points, last_pred);
+    }
+
+    range.first_block = static_cast<uint64_t>(first.hi);
+    range.last_block = static_cast<uint64_t>(last.hi);
+
+    // Timestamps are best effort - the block range is already known
+    std::vector<uint64_t> blocks{range.first_block};
+    if (range.last_block != range.first_block) blocks.push_back(range.last_block);
+    if (auto timestamps = fetch_timestamps(rpc_url, blocks, range.round_trips)) {
+        range.first_timestamp = timestamps->front();
+        range.last_timestamp = timestamps->back();
+    }
+
+    return range;
+}
+
+std::optional<uint64_t> block_timestamp(const std::string& rpc_url, uint64_t block) {
+    size_t round_trips = 0;
+    auto timestamps = fetch_timestamps(rpc_url, {block}, round_trips);
+    if (!timestamps || timestamps->front() == 0) {
+        return std::nullopt;
+    }
+    return timestamps->front();
+}
+
+} // namespace ActivityFinder
@@ -0,0 +1,50 @@
+#ifndef ACTIVITY_HPP
+#define ACTIVITY_HPP
+
+#include <cstdint>
+#include <string>
+#include <optional>
+
+/**
+ * First and last block in which an address changed state on a chain
+ */
+struct ActivityRange {
+    bool has_activity;          // nonce > 0 or balance > 0 at the latest block
+    uint64_t first_block;       // first block with nonce > 0 or balance > 0
+    uint64_t last_block;        // first block with the latest nonce and balance
+    uint64_t first_timestamp;   // unix time of first_block (0 if unknown)
+    uint64_t last_timestamp;    // unix time of last_block (0 if unknown)
+    uint64_t latest_block;      // chain head the search was pinned to
+    size_t round_trips;         // HTTP requests spent on the search
+};
+
+namespace ActivityFinder {
+
+constexpr size_t DEFAULT_FANOUT = 8;
+
+/**
+ * Find the first and last activity blocks of an address
+ * Runs a k-ary search over block heights: every round sends one batch with
+ * fanout - 1 probes per bound (eth_getTransactionCount + eth_getBalance),
+ * so the range is found in about log_fanout(head) round trips.
+ * Requires an endpoint that serves historical state (archive node).
+ * @param rpc_url RPC endpoint URL
+ * @param address Ethereum address (0x...)
+ * @param fanout Number of intervals each round splits the search range into
+ * @return ActivityRange, or nullopt if the endpoint failed or lacks history
+ */
+std::optional<ActivityRange> find_range(const std::string& rpc_url,
+                                        const std::string& address,
+                                        size_t fanout = DEFAULT_FANOUT);
+
+/**
+ * Get the timestamp of a block
+ * @param rpc_url RPC endpoint URL
+ * @param block Block number
+ * @return Unix timestamp, or nullopt on error
+ */
+std::optional<uint64_t> block_timestamp(const std::string& rpc_url, uint64_t block);
+
+} // namespace ActivityFinder
+
+#endif // ACTIVITY_HPP
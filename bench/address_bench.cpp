@@ -0,0 +1,50 @@
+#include "bench.hpp"
+#include "../address/address.hpp"
+
+extern "C" {
+#include "../sha3/keccak.h"
+#include "../sha3/sha3.h"
+}
+
+#include <string>
+
+namespace Bench {
+
+void run_address() {
+    const std::string checksummed = "0xd8dA6BF26964aF9D7eEd9e03E53415D37aA96045";
+    const std::string lower = "0xd8da6bf26964af9d7eed9e03e53415d37aa96045";
+    const std::string bad_checksum = "0xd8dA6BF26964aF9D7eEd9e03E53415D37aA96046";
+
+    run("address/is_valid", checksummed.size(), [&] {
+        do_not_optimize(Address::is_valid(checksummed));
+    });
+    run("address/to_checksum", lower.size(), [&] {
+        do_not_optimize(Address::to_checksum(lower));
+    });
+    run("address/verify_checksum", checksummed.size(), [&] {
+        do_not_optimize(Address::verify_checksum(checksummed));
+    });
+    run("address/verify_checksum/bad", bad_checksum.size(), [&] {
+        do_not_optimize(Address::verify_checksum(bad_checksum));
+    });
+
+    // One permutation of the 200-byte state
+    uint64_t state[25] = {};
+    state[0] = 0x0123456789abcdefULL;
+    run("keccakf1600", sizeof(state), [&] {
+        keccakf1600(state);
+        do_not_optimize(state[0]);
+    });
+
+    // The hash behind every checksum: 40 hex digits in, one block
+    uint8_t hash[SHA3_256_DIGEST_LENGTH];
+    run("keccak256/40B", 40, [&] {
+        SHA3_256_CTX ctx;
+        KECCAK_256_Init(&ctx);
+        KECCAK_256_Update(&ctx, reinterpret_cast<const uint8_t*>(lower.data() + 2), 40);
+        KECCAK_256_Final(hash, &ctx);
+        do_not_optimize(hash[0]);
+    });
+}
+
+} // namespace Bench
@@ -0,0 +1,87 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace Bench {
+
+/**
+ * Keep a value alive so the optimizer cannot drop the benchmarked work
+ */
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * Check if a benchmark was selected by the command-line filter
+ */
+bool selected(const char* name);
+
+/**
+ * Heap allocations made by the process so far (operator new calls)
+ */
+uint64_t allocations();
+
+/**
+ * Start a new peak-heap window
+ * @return Heap bytes in use now (operator new), the baseline of the window
+ */
+uint64_t reset_peak_heap();
+
+/**
+ * Most heap bytes in use since reset_peak_heap()
+ */
+uint64_t peak_heap();
+
+/**
+ * Print one result line (text, or one JSON object with --json)
+ * @param peak_bytes Most heap one iteration held on top of what was in use before it
+ */
+void report(const char* name, uint64_t iterations, double total_ns, size_t bytes_per_op, uint64_t allocs,
+            uint64_t peak_bytes);
+
+/**
+ * Run fn until at least ~200ms have elapsed and report ns/op
+ * @param name Benchmark name (used by the filter)
+ * @param bytes_per_op Input bytes processed per call, for throughput (0 to skip)
+ * @param fn Work to measure, called once per iteration
+ */
+template <typename F>
+void run(const char* name, size_t bytes_per_op, F&& fn) {
+    if (!selected(name)) return;
+
+    using clock = std::chrono::steady_clock;
+    constexpr double MIN_NS = 200e6;
+
+    // Grow the batch until one batch takes long enough to time reliably
+    uint64_t iterations = 1;
+    for (;;) {
+        uint64_t allocs_before = allocations();
+        uint64_t heap_before = reset_peak_heap();
+        auto start = clock::now();
+        for (uint64_t i = 0; i < iterations; i++) {
+            fn();
+        }
+        double elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+
+        if (elapsed >= MIN_NS || iterations >= (1ULL << 40)) {
+            report(name, iterations, elapsed, bytes_per_op, allocations() - allocs_before,
+                   peak_heap() > heap_before ? peak_heap() - heap_before : 0);
+            return;
+        }
+        iterations *= elapsed > 0 && MIN_NS / elapsed < 10 ? 2 : 10;
+    }
+}
+
+// Benchmark groups, one per source file
+void run_hex();
+void run_address();
+void run_rpc();
+
+} // namespace Bench
+
+#endif // BENCH_HPP
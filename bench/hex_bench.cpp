@@ -0,0 +1,108 @@
+#include "bench.hpp"
+#include "../rpc/rpc.hpp"
+#include "../uint256/uint256.hpp"
+
+extern "C" {
+#include "../hex/hex.h"
+}
+
+#include <string>
+#include <vector>
+
+namespace {
+
+// What hex_to_uint64 did before the shared decoder: two substr copies + stoull
+uint64_t legacy_hex_to_uint64(const std::string& hex) {
+    std::string h = hex;
+    if (h.substr(0, 2) == "0x" || h.substr(0, 2) == "0X") {
+        h = h.substr(2);
+    }
+    try {
+        return std::stoull(h, nullptr, 16);
+    } catch (...) {
+        return 0;
+    }
+}
+
+// Byte-at-a-time decoding, the baseline for the SIMD paths
+bool scalar_decode(const char* hex, size_t len, uint8_t* out) {
+    for (size_t i = 0; i < len / 2; i++) {
+        if (!is_hex_char(hex[i * 2]) || !is_hex_char(hex[i * 2 + 1])) return false;
+        out[i] = static_cast<uint8_t>((hex_char_to_nibble(hex[i * 2]) << 4) | hex_char_to_nibble(hex[i * 2 + 1]));
+    }
+    return true;
+}
+
+std::string make_hex(size_t digits) {
+    static const char chars[] = "0123456789abcdefABCDEF";
+    std::string s = "0x";
+    for (size_t i = 0; i < digits; i++) {
+        s += chars[(i * 7 + 3) % 22];
+    }
+    return s;
+}
+
+} // anonymous namespace
+
+namespace Bench {
+
+void run_hex() {
+    const std::string nonce = "0x1b4";
+    const std::string balance = "0x661efdf12d1653cf340011";
+    const std::string word = make_hex(64);
+    const std::string bytecode = make_hex(48 * 1024);  // 24 KB contract
+
+    std::vector<uint8_t> out(bytecode.size() / 2);
+
+    run("hex_to_uint64/legacy", nonce.size(), [&] {
+        do_not_optimize(legacy_hex_to_uint64(nonce));
+    });
+    run("hex_to_uint64", nonce.size(), [&] {
+        do_not_optimize(RpcClient::hex_to_uint64(nonce));
+    });
+    run("uint256_from_hex/balance", balance.size(), [&] {
+        do_not_optimize(Uint256::from_hex(balance));
+    });
+    run("uint256_from_hex/word", word.size(), [&] {
+        do_not_optimize(Uint256::from_hex(word));
+    });
+    run("hex_decode/32B/scalar", 64, [&] {
+        do_not_optimize(scalar_decode(word.data() + 2, 64, out.data()));
+        do_not_optimize(out[0]);
+    });
+    run("hex_decode/32B", 64, [&] {
+        do_not_optimize(hex_decode(word.data() + 2, 64, out.data()));
+        do_not_optimize(out[0]);
+    });
+    run("hex_decode/24KB/scalar", bytecode.size() - 2, [&] {
+        do_not_optimize(scalar_decode(bytecode.data() + 2, bytecode.size() - 2, out.data()));
+        do_not_optimize(out[0]);
+    });
+    run("hex_decode/24KB", bytecode.size() - 2, [&] {
+        do_not_optimize(hex_decode_data(bytecode.data(), bytecode.size(), out.data(), out.size()));
+        do_not_optimize(out[0]);
+    });
+    run("hex_to_bytes/32B", 64, [&] {
+        do_not_optimize(hex_to_bytes(word.data(), out.data(), word.size()));
+        do_not_optimize(out[0]);
+    });
+
+    std::vector<char> text(out.size() * 2 + 3);
+    run("bytes_to_hex/32B", 32, [&] {
+        bytes_to_hex(out.data(), 32, text.data(), true);
+        do_not_optimize(text[2]);
+    });
+    run("bytes_to_hex/24KB", out.size(), [&] {
+        bytes_to_hex(out.data(), out.size(), text.data(), true);
+        do_not_optimize(text[2]);
+    });
+
+    run("wei_to_eth/balance", balance.size(), [&] {
+        do_not_optimize(RpcClient::wei_to_eth(balance));
+    });
+    run("wei_to_eth/6_decimals", balance.size(), [&] {
+        do_not_optimize(RpcClient::wei_to_eth(balance, 6));
+    });
+}
+
+} // namespace Bench
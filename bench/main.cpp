@@ -0,0 +1,99 @@
+#include "bench.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <malloc.h>
+#include <new>
+
+static const char* filter = nullptr;
+static bool json_output = false;
+
+// Every operator new goes through here, so allocations/op and peak heap need no hooks
+static std::atomic<uint64_t> allocation_count{0};
+static std::atomic<uint64_t> heap_live{0};
+static std::atomic<uint64_t> heap_high{0};
+
+void* operator new(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size > 0 ? size : 1)) {
+        uint64_t bytes = malloc_usable_size(p);
+        uint64_t live = heap_live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        uint64_t high = heap_high.load(std::memory_order_relaxed);
+        while (live > high && !heap_high.compare_exchange_weak(high, live, std::memory_order_relaxed)) {
+        }
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    if (p) heap_live.fetch_sub(malloc_usable_size(p), std::memory_order_relaxed);
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+namespace Bench {
+
+bool selected(const char* name) {
+    return filter == nullptr || std::strstr(name, filter) != nullptr;
+}
+
+uint64_t allocations() {
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+uint64_t reset_peak_heap() {
+    uint64_t live = heap_live.load(std::memory_order_relaxed);
+    heap_high.store(live, std::memory_order_relaxed);
+    return live;
+}
+
+uint64_t peak_heap() {
+    return heap_high.load(std::memory_order_relaxed);
+}
+
+void report(const char* name, uint64_t iterations, double total_ns, size_t bytes_per_op, uint64_t allocs,
+            uint64_t peak_bytes) {
+    double ns_per_op = total_ns / static_cast<double>(iterations);
+    double allocs_per_op = static_cast<double>(allocs) / static_cast<double>(iterations);
+    double mb_per_s = bytes_per_op > 0 ? static_cast<double>(bytes_per_op) * 1e3 / ns_per_op : 0.0;
+
+    // One object per line, for tracking results across releases
+    if (json_output) {
+        std::printf("{\"name\":\"%s\",\"ns_per_op\":%.2f,\"mb_per_s\":%.1f,\"allocs_per_op\":%.2f,"
+                    "\"peak_heap_bytes\":%llu,\"iterations\":%llu}\n",
+                    name, ns_per_op, mb_per_s, allocs_per_op, static_cast<unsigned long long>(peak_bytes),
+                    static_cast<unsigned long long>(iterations));
+        return;
+    }
+
+    std::printf("%-32s %12.2f ns/op", name, ns_per_op);
+    if (bytes_per_op > 0) {
+        std::printf(" %10.1f MB/s", mb_per_s);
+    } else {
+        std::printf(" %16s", "");
+    }
+    std::printf(" %8.2f allocs/op %9.1f KB peak  (%llu iterations)\n", allocs_per_op,
+                static_cast<double>(peak_bytes) / 1024.0, static_cast<unsigned long long>(iterations));
+}
+
+} // namespace Bench
+
+int main(int argc, char* argv[]) {
+    // --json for machine-readable output; an optional substring filter, e.g. ./bench hex_decode
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--json") == 0) {
+            json_output = true;
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    Bench::run_hex();
+    Bench::run_address();
+    Bench::run_rpc();
+    return 0;
+}
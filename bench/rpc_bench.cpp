@@ -0,0 +1,128 @@
+#include "bench.hpp"
+#include "../chain/chain.hpp"
+#include "../chain/snapshot.hpp"
+#include "../include/json.hpp"
+#include "../model/chain_model.hpp"
+#include "../rpc/rpc.hpp"
+#include "../uint256/uint256.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+namespace {
+
+// Checked in so registry timings compare across releases
+const char* const FIXTURE_PATH = "bench/fixtures/rpcs.json";
+
+// Answer to the eth_getBalance + eth_getTransactionCount + eth_blockNumber batch
+const char* const BATCH_RESPONSE =
+    "[{\"jsonrpc\":\"2.0\",\"id\":1,\"result\":\"0x661efdf12d1653cf340011\"},"
+    "{\"jsonrpc\":\"2.0\",\"id\":2,\"result\":\"0x1b4\"},"
+    "{\"jsonrpc\":\"2.0\",\"id\":3,\"result\":\"0x13a5f2c\"}]";
+
+// eth_getProof answer with a typical 8-node account proof
+std::string make_proof_response() {
+    std::string node = "\"0x" + std::string(1064, 'a') + "\"";
+    std::string proof = "[" + node;
+    for (int i = 1; i < 8; i++) {
+        proof += "," + node;
+    }
+    proof += "]";
+    return "[{\"jsonrpc\":\"2.0\",\"id\":1,\"result\":{"
+           "\"address\":\"0xd8da6bf26964af9d7eed9e03e53415d37aa96045\","
+           "\"accountProof\":" + proof + ","
+           "\"balance\":\"0x661efdf12d1653cf340011\","
+           "\"codeHash\":\"0xc5d2460186f7233c927e7db2dcc703c0e500b653ca82273b7bfad8045d85a470\","
+           "\"nonce\":\"0x1b4\","
+           "\"storageHash\":\"0x56e81f171bcc55a6ff8345e692c0f86e5b48e01b996cadc001622fb5e363b421\","
+           "\"storageProof\":[]}},"
+           "{\"jsonrpc\":\"2.0\",\"id\":2,\"result\":\"0x13a5f2c\"}]";
+}
+
+// The extraction check_address does for a batch answer
+uint64_t read_batch(const json& results) {
+    uint64_t sum = 0;
+    for (const auto& r : results) {
+        if (!r.contains("result") || !r.contains("id")) continue;
+        const auto& value = r["result"].get_ref<const std::string&>();
+        if (r["id"].get<int>() == 1) {
+            sum += Uint256::from_hex(value).has_value();
+        } else {
+            sum += RpcClient::hex_to_uint64(value);
+        }
+    }
+    return sum;
+}
+
+} // anonymous namespace
+
+namespace Bench {
+
+void run_rpc() {
+    const std::string batch = BATCH_RESPONSE;
+    const std::string proof = make_proof_response();
+
+    run("rpc_parse/batch", batch.size(), [&] {
+        json results = json::parse(batch);
+        do_not_optimize(read_batch(results));
+    });
+    run("rpc_parse/proof", proof.size(), [&] {
+        json results = json::parse(proof);
+        do_not_optimize(results.size());
+    });
+
+    // What check_address_proof does: proof nodes are skipped while parsing
+    json::parser_callback_t drop_proof = [](int, json::parse_event_t event, json& parsed) {
+        if (event != json::parse_event_t::key) return true;
+        return parsed != "accountProof" && parsed != "storageProof";
+    };
+    run("rpc_parse/proof/drop_nodes", proof.size(), [&] {
+        json results = json::parse(proof, drop_proof);
+        do_not_optimize(results.size());
+    });
+
+    if (selected("registry_load")) {
+        std::ifstream fixture(FIXTURE_PATH, std::ios::binary | std::ios::ate);
+        if (!fixture) {
+            std::fprintf(stderr, "registry_load: %s not found (run from the repository root)\n", FIXTURE_PATH);
+            return;
+        }
+        size_t size = static_cast<size_t>(fixture.tellg());
+        run("registry_load", size, [&] {
+            do_not_optimize(ChainRegistry::load(FIXTURE_PATH));
+        });
+        
+        // The DOM + chainlist model path the streaming parse replaced, for comparison
+        run("registry_load/dom", size, [&] {
+            std::ifstream f(FIXTURE_PATH);
+            auto configs = json::parse(f).get<std::vector<Model::ChainConfig>>();
+            do_not_optimize(configs.size());
+        });
+        
+        // The same registry compiled to a snapshot: mapping it, and the two ways it is read
+        auto source = RegistrySnapshot::source_of(FIXTURE_PATH);
+        std::string snapshot_path = "/tmp/bench_rpcs." + std::to_string(getpid()) + ".bin";
+        if (!ChainRegistry::load(FIXTURE_PATH) ||
+            !RegistrySnapshot::write(snapshot_path, ChainRegistry::get_all(), *source)) {
+            std::fprintf(stderr, "registry_snapshot: cannot write %s\n", snapshot_path.c_str());
+            return;
+        }
+        run("registry_snapshot/open", 0, [&] {
+            do_not_optimize(RegistrySnapshot::open(snapshot_path, *source));
+        });
+        run("registry_snapshot/get_by_id", 0, [&] {
+            do_not_optimize(RegistrySnapshot::decode(*RegistrySnapshot::find_id(8453)));
+        });
+        run("registry_snapshot/decode_all", 0, [&] {
+            do_not_optimize(RegistrySnapshot::decode_all().size());
+        });
+        RegistrySnapshot::close();
+        std::remove(snapshot_path.c_str());
+    }
+}
+
+} // namespace Bench
@@ -0,0 +1,323 @@
+// End-to-end scan benchmark: scan_all and the multi-address scheduler
+// against simulated endpoints on loopback, across a matrix of thread,
+// chain and address counts.
+#include "sim_endpoint.hpp"
+#include "../chain/chain.hpp"
+#include "../include/json.hpp"
+#include "../metrics/metrics.hpp"
+#include "../multi_checker/multi_checker.hpp"
+#include "../scheduler/scan_scheduler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+namespace {
+
+struct Config {
+    std::vector<size_t> threads = {4, 16, 64};
+    std::vector<size_t> chains = {200, 500};
+    std::vector<size_t> addresses = {1, 4};
+    double hang_rate = 0.0;  // chains whose first endpoint never answers
+    bool json_output = false;
+};
+
+struct RunResult {
+    size_t threads, chains, addresses;
+    double wall_s;
+    uint64_t requests;
+    uint64_t rate_limited;
+    double p50_ms, p99_ms;
+    double peak_rss_mb;
+    double cpu_self_s;   // scanner process
+    double cpu_curl_s;   // curl children
+    size_t results;      // chains with activity, over all addresses
+};
+
+bool parse_list(const char* text, std::vector<size_t>& out) {
+    out.clear();
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        try {
+            size_t value = std::stoull(item);
+            if (value == 0) return false;
+            out.push_back(value);
+        } catch (...) {
+            return false;
+        }
+    }
+    return !out.empty();
+}
+
+// Five ordinary providers, a slow one, a rate-limited one and one that never answers
+std::vector<SimHost> default_hosts() {
+    std::vector<SimHost> hosts;
+    for (int i = 0; i < 5; i++) {
+        SimHost host;
+        host.ip = "127.0.0." + std::to_string(2 + i);
+        hosts.push_back(host);
+    }
+    SimHost slow;
+    slow.ip = "127.0.0.7";
+    slow.median_ms = 120.0;
+    slow.sigma = 0.5;
+    hosts.push_back(slow);
+
+    SimHost limited;
+    limited.ip = "127.0.0.8";
+    limited.kind = SimHost::Kind::RateLimited;
+    limited.median_ms = 30.0;
+    limited.max_concurrent = 8;
+    hosts.push_back(limited);
+
+    SimHost hang;
+    hang.ip = "127.0.0.9";
+    hang.kind = SimHost::Kind::Hang;
+    hosts.push_back(hang);
+    return hosts;
+}
+
+// chainlist-shaped registry: each chain on a primary host, 40% with a
+// second endpoint; 5% list a dead endpoint first and hang_rate a hanging one
+bool write_registry(const std::string& path, size_t count, const std::vector<SimHost>& hosts, double hang_rate) {
+    std::mt19937_64 rng(46 + count);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    size_t live_hosts = hosts.size() - 1;  // the last one hangs
+
+    json chains = json::array();
+    for (size_t i = 0; i < count; i++) {
+        uint64_t chain_id = 100000 + i;
+        json rpc = json::array();
+        double roll = unit(rng);
+        if (roll < 0.05) {
+            rpc.push_back({{"url", SimEndpoints::DEAD_URL}});
+        } else if (roll < 0.05 + hang_rate) {
+            rpc.push_back({{"url", SimEndpoints::url(hosts.back(), chain_id)}});
+        }
+        size_t primary = rng() % live_hosts;
+        rpc.push_back({{"url", SimEndpoints::url(hosts[primary], chain_id)}});
+        if (unit(rng) < 0.4) {
+            rpc.push_back({{"url", SimEndpoints::url(hosts[(primary + 1) % live_hosts], chain_id)}});
+        }
+        chains.push_back({
+            {"name", "Sim Chain " + std::to_string(i)},
+            {"chain", "SIM"},
+            {"rpc", rpc},
+            {"nativeCurrency", {{"name", "Ether"}, {"symbol", "ETH"}, {"decimals", 18}}},
+            {"chainId", chain_id},
+            {"networkId", chain_id},
+            {"isTestnet", i % 4 == 3},
+        });
+    }
+
+    std::ofstream out(path);
+    out << chains.dump();
+    return static_cast<bool>(out);
+}
+
+std::vector<std::string> make_addresses(size_t count) {
+    std::mt19937_64 rng(4600);
+    std::vector<std::string> addresses;
+    for (size_t i = 0; i < count; i++) {
+        char buf[43] = "0x";
+        for (int k = 0; k < 40; k++) {
+            buf[2 + k] = "0123456789abcdef"[rng() % 16];
+        }
+        addresses.emplace_back(buf, 42);
+    }
+    return addresses;
+}
+
+double seconds_of(const timeval& tv) {
+    return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / 1e6;
+}
+
+double cpu_seconds(int who) {
+    rusage usage{};
+    getrusage(who, &usage);
+    return seconds_of(usage.ru_utime) + seconds_of(usage.ru_stime);
+}
+
+// Peak RSS since the last reset (VmHWM), in MB
+double peak_rss_mb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return std::strtod(line.c_str() + 6, nullptr) / 1024.0;
+        }
+    }
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_maxrss) / 1024.0;
+}
+
+// Restart the VmHWM peak from the current RSS (Linux 4.0+); without it the
+// peak covers the whole process
+void reset_peak_rss() {
+    std::ofstream clear("/proc/self/clear_refs");
+    clear << "5";
+}
+
+RunResult run_scan(size_t threads, size_t chains, const std::vector<std::string>& addresses) {
+    ScanOptions options;
+    options.include_testnets = true;
+    options.num_threads = threads;
+    options.verbose = false;
+
+    Metrics::reset();
+    reset_peak_rss();
+    SimCounters& counters = SimEndpoints::counters();
+    uint64_t requests_before = counters.requests.load();
+    uint64_t limited_before = counters.rate_limited.load();
+    double self_before = cpu_seconds(RUSAGE_SELF);
+    double curl_before = cpu_seconds(RUSAGE_CHILDREN);
+    auto start = std::chrono::steady_clock::now();
+
+    std::atomic<size_t> results(0);
+    if (addresses.size() == 1) {
+        results = MultiChainChecker::scan_all(addresses[0], options).size();
+    } else {
+        ScanScheduler scheduler(options, [&results](const std::string&, uint64_t, std::vector<ChainResult>& found) {
+            results += found.size();
+        });
+        for (size_t i = 0; i < addresses.size(); i++) {
+            scheduler.add(addresses[i], i);
+        }
+        scheduler.finish();
+    }
+
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+    const LatencyHistogram& latency = Metrics::chain_latency();
+
+    RunResult r;
+    r.threads = threads;
+    r.chains = chains;
+    r.addresses = addresses.size();
+    r.wall_s = wall.count();
+    r.requests = counters.requests.load() - requests_before;
+    r.rate_limited = counters.rate_limited.load() - limited_before;
+    r.p50_ms = latency.quantile(0.50) * 1000.0;
+    r.p99_ms = latency.quantile(0.99) * 1000.0;
+    r.peak_rss_mb = peak_rss_mb();
+    r.cpu_self_s = cpu_seconds(RUSAGE_SELF) - self_before;
+    r.cpu_curl_s = cpu_seconds(RUSAGE_CHILDREN) - curl_before;
+    r.results = results;
+    return r;
+}
+
+void report(const RunResult& r, bool json_output) {
+    double rps = r.wall_s > 0 ? static_cast<double>(r.requests) / r.wall_s : 0.0;
+    if (json_output) {
+        std::printf("{\"threads\":%zu,\"chains\":%zu,\"addresses\":%zu,\"wall_s\":%.3f,\"requests\":%llu,"
+                    "\"requests_per_s\":%.1f,\"rate_limited\":%llu,\"chain_p50_ms\":%.1f,\"chain_p99_ms\":%.1f,"
+                    "\"peak_rss_mb\":%.1f,\"cpu_self_s\":%.3f,\"cpu_curl_s\":%.3f,\"results\":%zu}\n",
+                    r.threads, r.chains, r.addresses, r.wall_s, static_cast<unsigned long long>(r.requests),
+                    rps, static_cast<unsigned long long>(r.rate_limited), r.p50_ms, r.p99_ms,
+                    r.peak_rss_mb, r.cpu_self_s, r.cpu_curl_s, r.results);
+    } else {
+        std::printf("%7zu %6zu %5zu %8.2f %8llu %8.1f %6llu %8.1f %8.1f %8.1f %8.2f %8.2f %7zu\n",
+                    r.threads, r.chains, r.addresses, r.wall_s, static_cast<unsigned long long>(r.requests),
+                    rps, static_cast<unsigned long long>(r.rate_limited), r.p50_ms, r.p99_ms,
+                    r.peak_rss_mb, r.cpu_self_s, r.cpu_curl_s, r.results);
+    }
+    std::fflush(stdout);
+}
+
+void print_usage(const char* prog) {
+    std::printf("Usage: %s [--threads 4,16,64] [--chains 200,500] [--addresses 1,4] [--hang-rate <f>] [--json]\n\n"
+                "Scans synthetic chains served by simulated endpoints on 127.0.0.2-9 (log-normal\n"
+                "latency, a slow host, a rate-limited host, dead endpoints) for every combination\n"
+                "of the lists. One address uses scan_all, several the multi-address scheduler.\n"
+                "--hang-rate puts an endpoint that never answers (a 5 s timeout) first on that\n"
+                "fraction of chains.\n", prog);
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    Config config;
+    for (int i = 1; i < argc; i++) {
+        std::vector<size_t>* list = nullptr;
+        if (std::strcmp(argv[i], "--threads") == 0) list = &config.threads;
+        if (std::strcmp(argv[i], "--chains") == 0) list = &config.chains;
+        if (std::strcmp(argv[i], "--addresses") == 0) list = &config.addresses;
+
+        if (list && i + 1 < argc) {
+            if (!parse_list(argv[++i], *list)) {
+                std::fprintf(stderr, "Error: Invalid list %s\n", argv[i]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--hang-rate") == 0 && i + 1 < argc) {
+            config.hang_rate = std::strtod(argv[++i], nullptr);
+            if (!(config.hang_rate >= 0.0 && config.hang_rate <= 0.95)) {
+                std::fprintf(stderr, "Error: Invalid hang rate\n");
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--json") == 0) {
+            config.json_output = true;
+        } else {
+            print_usage(argv[0]);
+            return std::strcmp(argv[i], "-h") == 0 || std::strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    // The servers fork before any thread starts
+    std::vector<SimHost> hosts = default_hosts();
+    pid_t server = SimEndpoints::start(hosts);
+    if (server < 0) {
+        std::fprintf(stderr, "Error: Cannot start simulated endpoints on 127.0.0.2-9\n");
+        return 1;
+    }
+
+    char dir_template[] = "/tmp/checker-scan-bench-XXXXXX";
+    if (!mkdtemp(dir_template)) {
+        SimEndpoints::stop(server);
+        return 1;
+    }
+    std::string dir = dir_template;
+
+    Metrics::enable();
+    size_t max_threads = *std::max_element(config.threads.begin(), config.threads.end());
+    MultiChainChecker::init_pool(max_threads);
+
+    if (!config.json_output) {
+        std::printf("%7s %6s %5s %8s %8s %8s %6s %8s %8s %8s %8s %8s %7s\n",
+                    "threads", "chains", "addrs", "wall_s", "requests", "req/s", "429s",
+                    "p50_ms", "p99_ms", "rss_mb", "cpu_s", "curl_s", "found");
+    }
+
+    int status = 0;
+    for (size_t chains : config.chains) {
+        std::string path = dir + "/rpcs-" + std::to_string(chains) + ".json";
+        if (!write_registry(path, chains, hosts, config.hang_rate) || !ChainRegistry::load(path)) {
+            std::fprintf(stderr, "Error: Cannot write the synthetic registry %s\n", path.c_str());
+            status = 1;
+            break;
+        }
+        for (size_t count : config.addresses) {
+            auto addresses = make_addresses(count);
+            for (size_t threads : config.threads) {
+                report(run_scan(threads, chains, addresses), config.json_output);
+            }
+        }
+        unlink(path.c_str());
+    }
+
+    rmdir(dir.c_str());
+    SimEndpoints::stop(server);
+    return status;
+}
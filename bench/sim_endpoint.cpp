@@ -0,0 +1,234 @@
+#include "sim_endpoint.hpp"
+#include "../include/json.hpp"
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+namespace {
+
+SimCounters* shared_counters = nullptr;
+
+std::string hex(uint64_t value) {
+    char buf[24];
+    std::snprintf(buf, sizeof(buf), "0x%llx", static_cast<unsigned long long>(value));
+    return buf;
+}
+
+// About one address in ten has activity on a given chain
+bool is_active(const std::string& address, uint64_t chain_id) {
+    uint64_t h = std::hash<std::string>{}(address) ^ (chain_id * 0x9e3779b97f4a7c15ULL);
+    return h % 10 == 0;
+}
+
+json answer(const json& call, uint64_t chain_id) {
+    json reply = {{"jsonrpc", "2.0"}, {"id", call.value("id", json())}};
+    std::string method = call.value("method", "");
+    const json params = call.value("params", json::array());
+    std::string address = params.size() > 0 && params[0].is_string() ? params[0].get<std::string>() : "";
+
+    if (method == "eth_getBalance") {
+        reply["result"] = is_active(address, chain_id) ? "0xde0b6b3a7640000" : "0x0";
+    } else if (method == "eth_getTransactionCount") {
+        reply["result"] = is_active(address, chain_id) ? "0x2a" : "0x0";
+    } else if (method == "eth_blockNumber") {
+        reply["result"] = "0x1312d00";
+    } else if (method == "eth_chainId") {
+        reply["result"] = hex(chain_id);
+    } else {
+        reply["error"] = {{"code", -32601}, {"message", "method not found"}};
+    }
+    return reply;
+}
+
+void send_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return;
+        sent += static_cast<size_t>(n);
+    }
+}
+
+void respond(int fd, int status, const char* reason, const std::string& body) {
+    send_all(fd, "HTTP/1.1 " + std::to_string(status) + " " + reason + "\r\n"
+                 "Content-Type: application/json\r\n"
+                 "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                 "Connection: close\r\n\r\n" + body);
+}
+
+// Read the head and a Content-Length body
+bool read_request(int fd, std::string& path, std::string& body) {
+    std::string data;
+    char buf[4096];
+    size_t head_end = std::string::npos;
+    while (head_end == std::string::npos) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) return false;
+        data.append(buf, static_cast<size_t>(n));
+        head_end = data.find("\r\n\r\n");
+    }
+
+    size_t path_start = data.find(' ');
+    size_t path_end = data.find(' ', path_start + 1);
+    if (path_start == std::string::npos || path_end == std::string::npos) return false;
+    path = data.substr(path_start + 1, path_end - path_start - 1);
+
+    size_t length = 0;
+    size_t header = data.find("Content-Length:");
+    if (header == std::string::npos) header = data.find("content-length:");
+    if (header != std::string::npos && header < head_end) {
+        length = std::strtoull(data.c_str() + header + 15, nullptr, 10);
+    }
+
+    body = data.substr(head_end + 4);
+    while (body.size() < length) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) return false;
+        body.append(buf, static_cast<size_t>(n));
+    }
+    return true;
+}
+
+void serve_connection(int fd, const SimHost& host, std::atomic<int>& in_flight) {
+    std::string path, body;
+    if (!read_request(fd, path, body)) {
+        close(fd);
+        return;
+    }
+    shared_counters->requests.fetch_add(1, std::memory_order_relaxed);
+
+    if (host.kind == SimHost::Kind::Hang) {
+        std::this_thread::sleep_for(std::chrono::seconds(60));
+        close(fd);
+        return;
+    }
+
+    int current = in_flight.fetch_add(1) + 1;
+    if (host.kind == SimHost::Kind::RateLimited && current > host.max_concurrent) {
+        in_flight.fetch_sub(1);
+        shared_counters->rate_limited.fetch_add(1, std::memory_order_relaxed);
+        respond(fd, 429, "Too Many Requests", "{\"error\":\"rate limited\"}");
+        close(fd);
+        return;
+    }
+
+    // Log-normal delay: most answers near the median, a long slow tail
+    thread_local std::mt19937_64 rng(std::random_device{}());
+    std::normal_distribution<double> normal(0.0, 1.0);
+    double delay_ms = host.median_ms * std::exp(host.sigma * normal(rng));
+    std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64_t>(delay_ms * 1000)));
+
+    uint64_t chain_id = 0;
+    if (path.rfind("/chain/", 0) == 0) {
+        chain_id = std::strtoull(path.c_str() + 7, nullptr, 10);
+    }
+
+    json request = json::parse(body, nullptr, false);
+    json reply;
+    if (request.is_array()) {
+        reply = json::array();
+        for (const auto& call : request) {
+            reply.push_back(answer(call, chain_id));
+        }
+    } else if (request.is_object()) {
+        reply = answer(request, chain_id);
+    }
+    in_flight.fetch_sub(1);
+
+    if (reply.is_null()) {
+        respond(fd, 400, "Bad Request", "{\"error\":\"invalid JSON\"}");
+    } else {
+        respond(fd, 200, "OK", reply.dump());
+    }
+    close(fd);
+}
+
+[[noreturn]] void serve(const std::vector<SimHost>& hosts, const std::vector<int>& listeners) {
+    std::vector<std::atomic<int>> in_flight(hosts.size());
+    for (size_t i = 0; i < hosts.size(); i++) {
+        std::thread([&, i] {
+            for (;;) {
+                int fd = accept(listeners[i], nullptr, nullptr);
+                if (fd < 0) continue;
+                std::thread(serve_connection, fd, std::cref(hosts[i]), std::ref(in_flight[i])).detach();
+            }
+        }).detach();
+    }
+    for (;;) {
+        pause();
+    }
+}
+
+} // anonymous namespace
+
+namespace SimEndpoints {
+
+pid_t start(std::vector<SimHost>& hosts) {
+    if (!shared_counters) {
+        void* mem = mmap(nullptr, sizeof(SimCounters), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) return -1;
+        shared_counters = new (mem) SimCounters();
+    }
+    shared_counters->requests = 0;
+    shared_counters->rate_limited = 0;
+
+    // Bind in the parent so the ports are known before the fork
+    std::vector<int> listeners;
+    for (auto& host : hosts) {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        socklen_t len = sizeof(addr);
+        if (fd < 0 || inet_pton(AF_INET, host.ip.c_str(), &addr.sin_addr) != 1 ||
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+            bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(fd, 1024) != 0 ||
+            getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+            if (fd >= 0) close(fd);
+            for (int l : listeners) close(l);
+            return -1;
+        }
+        host.port = ntohs(addr.sin_port);
+        listeners.push_back(fd);
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        serve(hosts, listeners);
+    }
+    for (int fd : listeners) {
+        close(fd);
+    }
+    return pid;
+}
+
+void stop(pid_t pid) {
+    if (pid > 0) {
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+    }
+}
+
+SimCounters& counters() {
+    return *shared_counters;
+}
+
+std::string url(const SimHost& host, uint64_t chain_id) {
+    return "http://" + host.ip + ":" + std::to_string(host.port) + "/chain/" + std::to_string(chain_id);
+}
+
+} // namespace SimEndpoints
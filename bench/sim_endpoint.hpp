@@ -0,0 +1,76 @@
+#ifndef SIM_ENDPOINT_HPP
+#define SIM_ENDPOINT_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+/**
+ * Simulated JSON-RPC endpoint host on a loopback address
+ */
+struct SimHost {
+    enum class Kind {
+        Normal,       // answers after a log-normal delay
+        RateLimited,  // answers HTTP 429 above max_concurrent requests in flight
+        Hang,         // accepts and never answers (clients time out)
+    };
+
+    std::string ip;             // 127.0.0.N, so every host has its own name
+    Kind kind = Kind::Normal;
+    double median_ms = 25.0;    // latency median
+    double sigma = 0.8;         // log-normal shape; 0.8 puts p99 near 6x the median
+    int max_concurrent = 0;     // RateLimited only
+    uint16_t port = 0;          // set by SimEndpoints::start
+};
+
+/**
+ * Request counts, shared with the server process
+ */
+struct SimCounters {
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> rate_limited{0};
+};
+
+/**
+ * Loopback JSON-RPC servers for the end-to-end scan benchmark
+ *
+ * The servers run in a forked child process, so their CPU time and memory
+ * stay out of the scanner's numbers. Any chain ID is served under
+ * /chain/<id>: eth_getBalance and eth_getTransactionCount report activity
+ * for about one address in ten, eth_blockNumber and eth_chainId answer.
+ */
+namespace SimEndpoints {
+
+/**
+ * URL of an endpoint that refuses connections
+ */
+constexpr const char* DEAD_URL = "http://127.0.0.254:1/";
+
+/**
+ * Bind every host and start serving them in a child process
+ * Call before starting any thread.
+ * @param hosts Hosts to serve; their ports are filled in
+ * @return Child PID, or -1 on failure
+ */
+pid_t start(std::vector<SimHost>& hosts);
+
+/**
+ * Stop the server process
+ */
+void stop(pid_t pid);
+
+/**
+ * Counters of the running servers (zeroed by start)
+ */
+SimCounters& counters();
+
+/**
+ * Endpoint URL of a chain on a host
+ */
+std::string url(const SimHost& host, uint64_t chain_id);
+
+} // namespace SimEndpoints
+
+#endif // SIM_ENDPOINT_HPP
@@ -0,0 +1,40 @@
+#ifndef ACCOUNT_KEY_HPP
+#define ACCOUNT_KEY_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+extern "C" {
+#include "../hex/hex.h"
+}
+
+/**
+ * Decode a 0x-prefixed address into its 20 bytes
+ * @return false if the string is not a 20-byte hex value
+ */
+inline bool parse_account_address(std::string_view address, uint8_t out[20]) {
+    return hex_decode_data(address.data(), address.size(), out, 20) == 20;
+}
+
+/**
+ * 64-bit hash of a (chain ID, address) pair, shared by the on-disk caches
+ * Mixes the five address words into the chain ID, then applies the
+ * splitmix64 finalizer. The file formats depend on it - do not change.
+ */
+inline uint64_t account_key_hash(uint64_t chain_id, const uint8_t address[20]) {
+    uint64_t h = chain_id * 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < 20; i += 4) {
+        uint32_t word;
+        std::memcpy(&word, address + i, sizeof(word));
+        h ^= word + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+    }
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBULL;
+    h ^= h >> 31;
+    return h;
+}
+
+#endif // ACCOUNT_KEY_HPP
@@ -0,0 +1,222 @@
+#include "empty_filter.hpp"
+#include "account_key.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char MAGIC[8] = {'A', 'C', 'E', 'M', 'P', 'T', 'Y', '1'};
+constexpr uint32_t VERSION = 1;
+
+constexpr uint64_t BLOCK_BITS = 512;
+constexpr uint64_t BLOCK_WORDS = BLOCK_BITS / 64;
+constexpr uint32_t MAX_HASHES = 16;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t hashes;          // bits set per key
+    uint64_t blocks;          // 64-byte blocks per generation
+    uint64_t expiry_sec;
+    uint64_t started_at[2];   // when each generation was last cleared
+    uint32_t current;         // generation receiving inserts
+    uint32_t reserved0;
+    uint64_t reserved[9];
+};
+
+static_assert(sizeof(Header) == 128, "filter header layout");
+
+std::mutex map_mutex;
+int map_fd = -1;
+void* mapping = nullptr;
+size_t mapping_size = 0;
+Header* header = nullptr;
+uint64_t* bits = nullptr;
+
+uint64_t now_sec() {
+    return static_cast<uint64_t>(std::time(nullptr));
+}
+
+uint64_t* generation(uint32_t gen) {
+    return bits + gen * header->blocks * BLOCK_WORDS;
+}
+
+// Block index and the in-block bit positions of a key
+struct Probe {
+    uint64_t block;
+    uint32_t first;
+    uint32_t step;
+};
+
+Probe probe_for(uint64_t chain_id, const uint8_t address[20]) {
+    uint64_t h = account_key_hash(chain_id, address);
+
+    // Multiply-shift maps the high half to a block, the low half picks bits
+    Probe p;
+    p.block = static_cast<uint64_t>((static_cast<unsigned __int128>(h) * header->blocks) >> 64);
+    uint64_t mix = h * 0xD6E8FEB86659FD93ULL;
+    p.first = static_cast<uint32_t>(mix & (BLOCK_BITS - 1));
+    p.step = static_cast<uint32_t>((mix >> 32) | 1);
+    return p;
+}
+
+bool test_bits(const uint64_t* gen, const Probe& p) {
+    const uint64_t* block = gen + p.block * BLOCK_WORDS;
+    for (uint32_t i = 0; i < header->hashes; i++) {
+        uint32_t bit = (p.first + i * p.step) & (BLOCK_BITS - 1);
+        if ((__atomic_load_n(&block[bit / 64], __ATOMIC_RELAXED) & (1ULL << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Start a new generation once the current one is half an expiry old
+void maybe_rotate() {
+    uint64_t now = now_sec();
+    uint32_t cur = __atomic_load_n(&header->current, __ATOMIC_ACQUIRE);
+    if (now < header->started_at[cur] + header->expiry_sec / 2) {
+        return;
+    }
+
+    // Other processes may race to rotate - the file lock picks one
+    flock(map_fd, LOCK_EX);
+    cur = __atomic_load_n(&header->current, __ATOMIC_ACQUIRE);
+    if (now >= header->started_at[cur] + header->expiry_sec / 2) {
+        uint32_t next = cur ^ 1;
+        std::memset(generation(next), 0, header->blocks * BLOCK_WORDS * sizeof(uint64_t));
+        header->started_at[next] = now;
+        __atomic_store_n(&header->current, next, __ATOMIC_RELEASE);
+    }
+    flock(map_fd, LOCK_UN);
+}
+
+} // anonymous namespace
+
+namespace EmptyFilter {
+
+bool open(const std::string& path, uint64_t expected_entries, double fpr, uint64_t expiry_sec) {
+    std::lock_guard<std::mutex> lock(map_mutex);
+    if (mapping) return true;
+
+    if (expected_entries == 0) expected_entries = 1;
+    if (!(fpr > 0.0 && fpr < 1.0)) fpr = DEFAULT_FPR;
+    if (expiry_sec < 2) expiry_sec = 2;
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        std::cerr << "Warning: Cannot open empty filter " << path << "\n";
+        return false;
+    }
+
+    flock(fd, LOCK_EX);
+
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0;
+    if (ok && st.st_size == 0) {
+        // Optimal Bloom size, plus 10% for the load imbalance between blocks
+        double ln2 = std::log(2.0);
+        double m = -static_cast<double>(expected_entries) * std::log(fpr) / (ln2 * ln2) * 1.1;
+        uint64_t blocks = static_cast<uint64_t>(std::ceil(m / BLOCK_BITS));
+        double k = std::round(m / static_cast<double>(expected_entries) * ln2);
+
+        Header h{};
+        std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+        h.version = VERSION;
+        h.hashes = static_cast<uint32_t>(std::min<double>(std::max(k, 1.0), MAX_HASHES));
+        h.blocks = blocks > 0 ? blocks : 1;
+        h.expiry_sec = expiry_sec;
+        h.started_at[0] = now_sec();
+
+        off_t size = static_cast<off_t>(sizeof(Header) + 2 * h.blocks * BLOCK_BITS / 8);
+        ok = ftruncate(fd, size) == 0 && pwrite(fd, &h, sizeof(h), 0) == static_cast<ssize_t>(sizeof(h));
+        st.st_size = size;
+    }
+
+    Header h{};
+    if (ok) {
+        ok = pread(fd, &h, sizeof(h), 0) == static_cast<ssize_t>(sizeof(h)) &&
+             std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) == 0 && h.version == VERSION &&
+             h.blocks > 0 && h.hashes >= 1 && h.hashes <= MAX_HASHES && h.current <= 1 &&
+             static_cast<uint64_t>(st.st_size) == sizeof(Header) + 2 * h.blocks * BLOCK_BITS / 8;
+    }
+
+    void* addr = MAP_FAILED;
+    if (ok) {
+        addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+
+    flock(fd, LOCK_UN);
+
+    if (addr == MAP_FAILED) {
+        ::close(fd);
+        std::cerr << "Warning: Empty filter " << path << " is invalid - delete it to start over\n";
+        return false;
+    }
+
+    // The fd stays open for the rotation lock
+    map_fd = fd;
+    mapping = addr;
+    mapping_size = static_cast<size_t>(st.st_size);
+    header = static_cast<Header*>(addr);
+    bits = reinterpret_cast<uint64_t*>(static_cast<char*>(addr) + sizeof(Header));
+    header->expiry_sec = expiry_sec;
+
+    maybe_rotate();
+    return true;
+}
+
+void close() {
+    std::lock_guard<std::mutex> lock(map_mutex);
+    if (mapping) {
+        munmap(mapping, mapping_size);
+        ::close(map_fd);
+    }
+    map_fd = -1;
+    mapping = nullptr;
+    mapping_size = 0;
+    header = nullptr;
+    bits = nullptr;
+}
+
+bool is_open() {
+    return mapping != nullptr;
+}
+
+bool contains(uint64_t chain_id, std::string_view address) {
+    uint8_t key[20];
+    if (!bits || !parse_account_address(address, key)) {
+        return false;
+    }
+
+    Probe p = probe_for(chain_id, key);
+    return test_bits(generation(0), p) || test_bits(generation(1), p);
+}
+
+void insert(uint64_t chain_id, std::string_view address) {
+    uint8_t key[20];
+    if (!bits || !parse_account_address(address, key)) {
+        return;
+    }
+
+    maybe_rotate();
+
+    Probe p = probe_for(chain_id, key);
+    uint64_t* block = generation(__atomic_load_n(&header->current, __ATOMIC_ACQUIRE)) + p.block * BLOCK_WORDS;
+    for (uint32_t i = 0; i < header->hashes; i++) {
+        uint32_t bit = (p.first + i * p.step) & (BLOCK_BITS - 1);
+        __atomic_fetch_or(&block[bit / 64], 1ULL << (bit % 64), __ATOMIC_RELAXED);
+    }
+}
+
+} // namespace EmptyFilter
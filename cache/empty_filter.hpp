@@ -0,0 +1,63 @@
+#ifndef EMPTY_FILTER_HPP
+#define EMPTY_FILTER_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * On-disk negative cache for (chain, address) pairs found empty
+ * (zero balance and zero nonce). A blocked Bloom filter: every key sets
+ * its bits inside one 64-byte block, so a lookup touches one cache line.
+ * Two generations rotate every expiry / 2, so an entry is forgotten
+ * between expiry / 2 and expiry after it was added. False positives are
+ * possible, false negatives are not.
+ */
+namespace EmptyFilter {
+
+constexpr const char* DEFAULT_PATH = "data/empty.filter";
+constexpr uint64_t DEFAULT_ENTRIES = 1000000;     // expected inserts per generation
+constexpr double DEFAULT_FPR = 0.01;
+constexpr uint64_t DEFAULT_EXPIRY = 7 * 86400;    // seconds
+
+/**
+ * Open (or create) the filter file and map it
+ * Sizing parameters only apply when the file is created.
+ * @param path Filter file path
+ * @param expected_entries Expected inserts per generation
+ * @param fpr Target false-positive rate at expected_entries
+ * @param expiry_sec Entry lifetime in seconds (updated on existing files)
+ * @return true if the filter is ready to use
+ */
+bool open(const std::string& path = DEFAULT_PATH,
+          uint64_t expected_entries = DEFAULT_ENTRIES,
+          double fpr = DEFAULT_FPR,
+          uint64_t expiry_sec = DEFAULT_EXPIRY);
+
+/**
+ * Unmap the filter file
+ */
+void close();
+
+/**
+ * Check if a filter file is mapped
+ */
+bool is_open();
+
+/**
+ * Check if a pair was recorded as empty (may return false positives)
+ * @param chain_id Chain ID
+ * @param address Ethereum address (0x...)
+ */
+bool contains(uint64_t chain_id, std::string_view address);
+
+/**
+ * Record a pair as empty in the current generation
+ * @param chain_id Chain ID
+ * @param address Ethereum address (0x...)
+ */
+void insert(uint64_t chain_id, std::string_view address);
+
+} // namespace EmptyFilter
+
+#endif // EMPTY_FILTER_HPP
@@ -0,0 +1,281 @@
+#include "result_cache.hpp"
+#include "account_key.hpp"
+
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char MAGIC[8] = {'A', 'C', 'R', 'C', 'A', 'C', 'H', 'E'};
+constexpr uint32_t VERSION = 1;
+
+// Slots probed per key before evicting the oldest one
+constexpr uint64_t MAX_PROBE = 8;
+
+// Sequence lock spins before a slot is treated as busy
+constexpr int MAX_SPIN = 64;
+
+constexpr uint32_t FLAG_CONTRACT = 1;
+constexpr uint32_t FLAG_CONTRACT_KNOWN = 2;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t slot_size;
+    uint64_t capacity;      // power of 2
+    uint64_t reserved[5];
+};
+
+// Written under the slot's sequence lock: seq is odd while a write is in progress
+struct Slot {
+    uint32_t seq;
+    uint32_t used;
+    uint64_t chain_id;
+    uint8_t address[20];
+    uint32_t flags;
+    uint64_t balance[4];
+    uint64_t tx_count;
+    uint64_t block;
+    uint64_t stored_at;
+};
+
+static_assert(sizeof(Header) == 64, "cache header layout");
+static_assert(sizeof(Slot) == 96, "cache slot layout");
+
+std::mutex map_mutex;
+void* mapping = nullptr;
+size_t mapping_size = 0;
+Header* header = nullptr;
+Slot* slots = nullptr;
+
+uint64_t now_sec() {
+    return static_cast<uint64_t>(std::time(nullptr));
+}
+
+// Consistent copy of a slot, or false if a writer kept it busy
+bool read_slot(const Slot& slot, Slot& copy) {
+    for (int spin = 0; spin < MAX_SPIN; spin++) {
+        uint32_t before = __atomic_load_n(&slot.seq, __ATOMIC_ACQUIRE);
+        if (before & 1) continue;
+
+        std::memcpy(&copy, &slot, sizeof(Slot));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if (__atomic_load_n(&slot.seq, __ATOMIC_RELAXED) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool lock_slot(Slot& slot, uint32_t& seq) {
+    for (int spin = 0; spin < MAX_SPIN; spin++) {
+        seq = __atomic_load_n(&slot.seq, __ATOMIC_RELAXED);
+        if (seq & 1) continue;
+        if (__atomic_compare_exchange_n(&slot.seq, &seq, seq + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void unlock_slot(Slot& slot, uint32_t seq) {
+    __atomic_store_n(&slot.seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+uint64_t round_up_pow2(uint64_t n) {
+    uint64_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+// Approximate block times (ms) of busy chains; others use the Ethereum default
+uint64_t block_time_ms(uint64_t chain_id) {
+    switch (chain_id) {
+        case 10: case 137: case 8453: case 43114: case 59144: case 81457: case 5000:
+            return 2000;
+        case 56: case 204: case 534352:
+            return 3000;
+        case 250: case 324: case 1101:
+            return 1000;
+        case 100:
+            return 5000;
+        case 42161: case 42170:
+            return 250;
+        default:
+            return 12000;
+    }
+}
+
+} // anonymous namespace
+
+namespace ResultCache {
+
+bool open(const std::string& path, uint64_t capacity) {
+    std::lock_guard<std::mutex> lock(map_mutex);
+    if (mapping) return true;
+
+    capacity = round_up_pow2(capacity < MAX_PROBE ? MAX_PROBE : capacity);
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        std::cerr << "Warning: Cannot open result cache " << path << "\n";
+        return false;
+    }
+
+    // Serialize initialization against other processes opening the same file
+    flock(fd, LOCK_EX);
+
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0;
+    if (ok && st.st_size == 0) {
+        // New file: slots start zeroed (sparse), only the header needs writing
+        Header h{};
+        std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+        h.version = VERSION;
+        h.slot_size = sizeof(Slot);
+        h.capacity = capacity;
+        off_t size = static_cast<off_t>(sizeof(Header) + capacity * sizeof(Slot));
+        ok = ftruncate(fd, size) == 0 && pwrite(fd, &h, sizeof(h), 0) == static_cast<ssize_t>(sizeof(h));
+        st.st_size = size;
+    }
+
+    Header h{};
+    if (ok) {
+        ok = pread(fd, &h, sizeof(h), 0) == static_cast<ssize_t>(sizeof(h)) &&
+             std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) == 0 &&
+             h.version == VERSION && h.slot_size == sizeof(Slot) &&
+             h.capacity >= MAX_PROBE && (h.capacity & (h.capacity - 1)) == 0 &&
+             static_cast<uint64_t>(st.st_size) == sizeof(Header) + h.capacity * sizeof(Slot);
+    }
+
+    void* addr = MAP_FAILED;
+    if (ok) {
+        addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+
+    flock(fd, LOCK_UN);
+    ::close(fd);
+
+    if (addr == MAP_FAILED) {
+        std::cerr << "Warning: Result cache " << path << " is invalid - delete it to start over\n";
+        return false;
+    }
+
+    mapping = addr;
+    mapping_size = static_cast<size_t>(st.st_size);
+    header = static_cast<Header*>(addr);
+    slots = reinterpret_cast<Slot*>(static_cast<char*>(addr) + sizeof(Header));
+    return true;
+}
+
+void close() {
+    std::lock_guard<std::mutex> lock(map_mutex);
+    if (mapping) {
+        munmap(mapping, mapping_size);
+    }
+    mapping = nullptr;
+    mapping_size = 0;
+    header = nullptr;
+    slots = nullptr;
+}
+
+bool is_open() {
+    return mapping != nullptr;
+}
+
+std::optional<CachedState> lookup(uint64_t chain_id, std::string_view address, uint64_t max_age_sec) {
+    uint8_t key[20];
+    if (!slots || !parse_account_address(address, key)) {
+        return std::nullopt;
+    }
+
+    uint64_t mask = header->capacity - 1;
+    uint64_t idx = account_key_hash(chain_id, key) & mask;
+    uint64_t now = now_sec();
+
+    // Concurrent inserts can leave duplicates in the window - keep the newest
+    std::optional<CachedState> best;
+    for (uint64_t i = 0; i < MAX_PROBE; i++) {
+        Slot copy;
+        if (!read_slot(slots[(idx + i) & mask], copy)) continue;
+        if (!copy.used) break;
+        if (copy.chain_id != chain_id || std::memcmp(copy.address, key, sizeof(key)) != 0) continue;
+        if (best && best->stored_at >= copy.stored_at) continue;
+
+        CachedState state;
+        std::memcpy(state.balance.limbs, copy.balance, sizeof(copy.balance));
+        state.tx_count = copy.tx_count;
+        state.is_contract = (copy.flags & FLAG_CONTRACT) != 0;
+        state.contract_known = (copy.flags & FLAG_CONTRACT_KNOWN) != 0;
+        state.block = copy.block;
+        state.stored_at = copy.stored_at;
+        best = state;
+    }
+
+    if (best && now > best->stored_at + max_age_sec) {
+        return std::nullopt;
+    }
+    return best;
+}
+
+void store(uint64_t chain_id, std::string_view address, const CachedState& state) {
+    uint8_t key[20];
+    if (!slots || !parse_account_address(address, key)) {
+        return;
+    }
+
+    uint64_t mask = header->capacity - 1;
+    uint64_t idx = account_key_hash(chain_id, key) & mask;
+
+    // Prefer the key's own slot, then an empty one, then the oldest in the window
+    Slot* target = nullptr;
+    Slot* oldest = nullptr;
+    uint64_t oldest_at = UINT64_MAX;
+    for (uint64_t i = 0; i < MAX_PROBE; i++) {
+        Slot& slot = slots[(idx + i) & mask];
+        Slot copy;
+        if (!read_slot(slot, copy)) continue;
+
+        if (!copy.used || (copy.chain_id == chain_id && std::memcmp(copy.address, key, sizeof(key)) == 0)) {
+            target = &slot;
+            break;
+        }
+        if (copy.stored_at < oldest_at) {
+            oldest_at = copy.stored_at;
+            oldest = &slot;
+        }
+    }
+    if (!target) target = oldest;
+    if (!target) return;
+
+    uint32_t seq;
+    if (!lock_slot(*target, seq)) {
+        return;  // another writer holds it, their value is as good as ours
+    }
+
+    target->used = 1;
+    target->chain_id = chain_id;
+    std::memcpy(target->address, key, sizeof(key));
+    target->flags = (state.is_contract ? FLAG_CONTRACT : 0) | (state.contract_known ? FLAG_CONTRACT_KNOWN : 0);
+    std::memcpy(target->balance, state.balance.limbs, sizeof(target->balance));
+    target->tx_count = state.tx_count;
+    target->block = state.block;
+    target->stored_at = now_sec();
+
+    unlock_slot(*target, seq);
+}
+
+uint64_t ttl_for(uint64_t chain_id, uint64_t ttl_blocks) {
+    uint64_t ttl = block_time_ms(chain_id) * ttl_blocks / 1000;
+    return ttl > 0 ? ttl : 1;
+}
+
+} // namespace ResultCache
@@ -0,0 +1,79 @@
+#ifndef RESULT_CACHE_HPP
+#define RESULT_CACHE_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <optional>
+#include "../uint256/uint256.hpp"
+
+/**
+ * Account state stored in the result cache
+ */
+struct CachedState {
+    Uint256 balance;
+    uint64_t tx_count;
+    bool is_contract;
+    bool contract_known;   // is_contract came from a codeHash
+    uint64_t block;        // block the state was read at (0 if unknown)
+    uint64_t stored_at;    // unix time of the write
+};
+
+/**
+ * On-disk result cache shared between processes
+ * A memory-mapped open-addressing hash table keyed by (chain ID, address).
+ * Each slot is guarded by a sequence lock, so any number of processes can
+ * read and write the same file concurrently without a global lock.
+ */
+namespace ResultCache {
+
+constexpr const char* DEFAULT_PATH = "data/results.cache";
+constexpr uint64_t DEFAULT_CAPACITY = 1 << 16;  // slots, ~6 MB
+constexpr uint64_t DEFAULT_TTL_BLOCKS = 25;
+
+/**
+ * Open (or create) the cache file and map it
+ * @param path Cache file path
+ * @param capacity Number of slots when creating a new file (rounded up to a power of 2)
+ * @return true if the cache is ready to use
+ */
+bool open(const std::string& path = DEFAULT_PATH, uint64_t capacity = DEFAULT_CAPACITY);
+
+/**
+ * Unmap the cache file
+ */
+void close();
+
+/**
+ * Check if a cache file is mapped
+ */
+bool is_open();
+
+/**
+ * Look up the state of an address on a chain
+ * @param chain_id Chain ID
+ * @param address Ethereum address (0x...)
+ * @param max_age_sec Maximum age of the entry in seconds
+ * @return Cached state, or nullopt on miss, expiry or if the cache is closed
+ */
+std::optional<CachedState> lookup(uint64_t chain_id, std::string_view address, uint64_t max_age_sec);
+
+/**
+ * Store the state of an address on a chain (stored_at is set to now)
+ * @param chain_id Chain ID
+ * @param address Ethereum address (0x...)
+ * @param state State to store
+ */
+void store(uint64_t chain_id, std::string_view address, const CachedState& state);
+
+/**
+ * Entry lifetime for a chain: ttl_blocks times the chain's block time
+ * @param chain_id Chain ID
+ * @param ttl_blocks Number of blocks an entry stays fresh
+ * @return Lifetime in seconds (at least 1)
+ */
+uint64_t ttl_for(uint64_t chain_id, uint64_t ttl_blocks = DEFAULT_TTL_BLOCKS);
+
+} // namespace ResultCache
+
+#endif // RESULT_CACHE_HPP
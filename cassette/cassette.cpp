@@ -0,0 +1,376 @@
+#include "cassette.hpp"
+#include "../include/json.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+constexpr char MAGIC[8] = {'R', 'P', 'C', 'C', 'A', 'S', '0', '1'};
+constexpr uint8_t RECORD_URL = 1;
+constexpr uint8_t RECORD_EXCHANGE = 2;
+
+// curl exit code for a refused connection, returned for unrecorded requests
+constexpr int CURL_COULDNT_CONNECT = 7;
+
+enum class Mode { Off, Record, Replay };
+
+std::mutex mutex;
+std::atomic<Mode> mode{Mode::Off};  // read without the lock on every request
+std::string cassette_path;
+
+// Recording
+std::string cassette_dir;
+std::ofstream out_file;
+std::unordered_map<std::string, uint32_t> url_ids;
+std::chrono::steady_clock::time_point record_start;
+uint64_t recorded = 0;
+
+// Replay, one entry per JSON-RPC call keyed by URL, method and params, so a
+// batch composed differently than when recording (the multi-address
+// scheduler batches whatever is pending) is answered call by call
+struct Take {
+    HttpExchange exchange;  // metadata; the whole exchange when reply is null
+    json reply;             // the call's response object (null: the exchange failed)
+};
+struct Takes {
+    std::vector<Take> takes;
+    size_t next = 0;
+};
+std::unordered_map<std::string, Takes> takes;
+double replay_speed = 1.0;
+uint64_t hits = 0;
+uint64_t misses = 0;
+
+template <typename T>
+void put(std::string& buf, T value) {
+    buf.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void put_bytes(std::string& buf, const std::string& bytes) {
+    put<uint32_t>(buf, static_cast<uint32_t>(bytes.size()));
+    buf += bytes;
+}
+
+// Replay key of one call; requests that are not JSON key on their body
+std::string call_key(const std::string& url, const json& call) {
+    if (call.is_object() && call.contains("method") && call["method"].is_string()) {
+        return url + '\n' + call["method"].get<std::string>() + '\n' +
+               (call.contains("params") ? call["params"].dump() : "null");
+    }
+    return url + '\n' + call.dump();
+}
+
+// Calls of a request as an array (a single call becomes a one-element batch)
+json calls_of(const std::string& request, bool& batch) {
+    json calls = json::parse(request, nullptr, false);
+    batch = calls.is_array();
+    if (!calls.is_discarded() && !batch) {
+        calls = json::array({std::move(calls)});
+    }
+    return calls;
+}
+
+// File a recorded exchange under each call it carried
+void index_exchange(std::unordered_map<std::string, Takes>& index, const std::string& url,
+                    const std::string& request, const HttpExchange& exchange) {
+    bool batch = false;
+    json calls = calls_of(request, batch);
+    if (calls.is_discarded()) {
+        index[url + '\n' + request].takes.push_back(Take{exchange, nullptr});
+        return;
+    }
+
+    json replies = exchange.http_code == 200 ? json::parse(exchange.response, nullptr, false) : json();
+    if (replies.is_object()) {
+        replies = json::array({std::move(replies)});
+    }
+    std::unordered_map<std::string, const json*> by_id;
+    if (replies.is_array()) {
+        for (const json& reply : replies) {
+            if (reply.is_object() && reply.contains("id")) by_id[reply["id"].dump()] = &reply;
+        }
+    }
+
+    for (const json& call : calls) {
+        Take take{exchange, nullptr};
+        auto reply = by_id.find(call.is_object() && call.contains("id") ? call["id"].dump() : "null");
+        if (reply != by_id.end()) {
+            take.reply = *reply->second;
+            take.exchange.response.clear();
+        }
+        index[call_key(url, call)].takes.push_back(std::move(take));
+    }
+}
+
+uint32_t micros(double seconds) {
+    return seconds > 0.0 ? static_cast<uint32_t>(seconds * 1e6 + 0.5) : 0;
+}
+
+// Bounds-checked reader over the loaded file
+struct Reader {
+    const std::string& data;
+    size_t pos = 0;
+
+    bool done() const { return pos >= data.size(); }
+
+    template <typename T>
+    bool get(T& value) {
+        if (data.size() - pos < sizeof(T)) return false;
+        std::memcpy(&value, data.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    template <typename Length>
+    bool get_bytes(std::string& bytes) {
+        Length length;
+        if (!get(length) || data.size() - pos < length) return false;
+        bytes.assign(data, pos, length);
+        pos += length;
+        return true;
+    }
+};
+
+} // anonymous namespace
+
+namespace Cassette {
+
+bool record_to(const std::string& dir) {
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    std::string path = (fs::path(dir) / FILE_NAME).string();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    out_file.open(path, std::ios::binary | std::ios::trunc);
+    if (!out_file) {
+        return false;
+    }
+    out_file.write(MAGIC, sizeof(MAGIC));
+
+    cassette_dir = dir;
+    cassette_path = path;
+    record_start = std::chrono::steady_clock::now();
+    mode = Mode::Record;
+    return true;
+}
+
+void save_registry(const std::string& registry_path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (mode != Mode::Record) {
+        return;
+    }
+    // Replays need the same chains and endpoint order
+    std::error_code ec;
+    fs::copy_file(registry_path, fs::path(cassette_dir) / REGISTRY_NAME, fs::copy_options::overwrite_existing, ec);
+}
+
+bool replay_from(const std::string& dir, double speed) {
+    std::string path = (fs::path(dir) / FILE_NAME).string();
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.size() < sizeof(MAGIC) || std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0) {
+        return false;
+    }
+
+    std::unordered_map<uint32_t, std::string> urls;
+    std::unordered_map<std::string, Takes> loaded;
+    Reader reader{data, sizeof(MAGIC)};
+    while (!reader.done()) {
+        uint8_t type = 0;
+        reader.get(type);
+        if (type == RECORD_URL) {
+            uint32_t id = 0;
+            std::string url;
+            if (!reader.get(id) || !reader.get_bytes<uint16_t>(url)) return false;
+            urls[id] = std::move(url);
+        } else if (type == RECORD_EXCHANGE) {
+            uint32_t url_id = 0, elapsed_us = 0, timers[6] = {}, sent = 0, received = 0;
+            uint64_t start_us = 0;
+            uint16_t http_code = 0;
+            uint8_t exit_code = 0;
+            std::string request;
+            HttpExchange exchange;
+            bool ok = reader.get(url_id) && reader.get(start_us) && reader.get(elapsed_us) &&
+                      reader.get(http_code) && reader.get(exit_code);
+            for (uint32_t& timer : timers) {
+                ok = ok && reader.get(timer);
+            }
+            ok = ok && reader.get(sent) && reader.get(received) &&
+                 reader.get_bytes<uint32_t>(request) && reader.get_bytes<uint32_t>(exchange.response);
+            auto url = urls.find(url_id);
+            if (!ok || url == urls.end()) return false;
+
+            exchange.exit_code = exit_code;
+            exchange.http_code = http_code;
+            exchange.namelookup = timers[0] / 1e6;
+            exchange.connect = timers[1] / 1e6;
+            exchange.appconnect = timers[2] / 1e6;
+            exchange.pretransfer = timers[3] / 1e6;
+            exchange.starttransfer = timers[4] / 1e6;
+            exchange.total = timers[5] / 1e6;
+            exchange.bytes_sent = sent;
+            exchange.bytes_received = received;
+            exchange.elapsed_ms = elapsed_us / 1e3;
+            index_exchange(loaded, url->second, request, exchange);
+        } else {
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    takes = std::move(loaded);
+    replay_speed = speed;
+    cassette_path = path;
+    mode = Mode::Replay;
+    return true;
+}
+
+bool recording() {
+    return mode == Mode::Record;
+}
+
+bool replaying() {
+    return mode == Mode::Replay;
+}
+
+void record(const std::string& url, const std::string& request, const HttpExchange& exchange) {
+    if (mode != Mode::Record) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    std::string buf;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (mode != Mode::Record) {
+        return;
+    }
+
+    auto [it, added] = url_ids.emplace(url, static_cast<uint32_t>(url_ids.size()));
+    if (added) {
+        put<uint8_t>(buf, RECORD_URL);
+        put<uint32_t>(buf, it->second);
+        put<uint16_t>(buf, static_cast<uint16_t>(std::min<size_t>(url.size(), UINT16_MAX)));
+        buf.append(url, 0, UINT16_MAX);
+    }
+
+    // The exchange started elapsed_ms before it was handed to us
+    auto since_start = std::chrono::duration_cast<std::chrono::microseconds>(now - record_start).count();
+    uint64_t elapsed_us = static_cast<uint64_t>(exchange.elapsed_ms * 1e3);
+    put<uint8_t>(buf, RECORD_EXCHANGE);
+    put<uint32_t>(buf, it->second);
+    put<uint64_t>(buf, static_cast<uint64_t>(since_start) > elapsed_us ? since_start - elapsed_us : 0);
+    put<uint32_t>(buf, static_cast<uint32_t>(elapsed_us));
+    put<uint16_t>(buf, static_cast<uint16_t>(exchange.http_code));
+    put<uint8_t>(buf, static_cast<uint8_t>(exchange.exit_code));
+    for (double timer : {exchange.namelookup, exchange.connect, exchange.appconnect,
+                         exchange.pretransfer, exchange.starttransfer, exchange.total}) {
+        put<uint32_t>(buf, micros(timer));
+    }
+    put<uint32_t>(buf, static_cast<uint32_t>(exchange.bytes_sent));
+    put<uint32_t>(buf, static_cast<uint32_t>(exchange.bytes_received));
+    put_bytes(buf, request);
+    put_bytes(buf, exchange.response);
+
+    out_file.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    recorded++;
+}
+
+HttpExchange replay(const std::string& url, const std::string& request) {
+    bool batch = false;
+    json calls = calls_of(request, batch);
+    std::vector<std::string> keys;
+    if (calls.is_discarded()) {
+        keys.push_back(url + '\n' + request);
+    } else {
+        for (const json& call : calls) {
+            keys.push_back(call_key(url, call));
+        }
+    }
+
+    // Each call takes its recordings in order, the last one repeating
+    HttpExchange exchange;
+    std::vector<Take> picks;
+    double speed;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        speed = replay_speed;
+        for (const std::string& key : keys) {
+            auto it = takes.find(key);
+            if (it == takes.end()) {
+                misses++;
+                exchange.exit_code = CURL_COULDNT_CONNECT;
+                return exchange;
+            }
+        }
+        for (const std::string& key : keys) {
+            Takes& take = takes[key];
+            picks.push_back(take.takes[std::min(take.next, take.takes.size() - 1)]);
+            take.next++;
+        }
+        hits++;
+    }
+
+    // A call whose exchange failed fails the request again; otherwise the
+    // replies are reassembled under this request's ids, at the pace of the
+    // slowest recorded call
+    auto failed = std::find_if(picks.begin(), picks.end(), [](const Take& t) { return t.reply.is_null(); });
+    if (failed != picks.end()) {
+        exchange = failed->exchange;
+    } else {
+        auto slowest = std::max_element(picks.begin(), picks.end(), [](const Take& a, const Take& b) {
+            return a.exchange.elapsed_ms < b.exchange.elapsed_ms;
+        });
+        exchange = slowest->exchange;
+        json replies = json::array();
+        for (size_t i = 0; i < picks.size(); i++) {
+            json reply = std::move(picks[i].reply);
+            if (calls[i].is_object() && calls[i].contains("id")) reply["id"] = calls[i]["id"];
+            replies.push_back(std::move(reply));
+        }
+        exchange.response = batch ? replies.dump() : replies[0].dump();
+        exchange.bytes_sent = request.size();
+        exchange.bytes_received = exchange.response.size();
+    }
+
+    // Time compression scales the timers along with the wait
+    if (speed > 0.0) {
+        for (double* timer : {&exchange.namelookup, &exchange.connect, &exchange.appconnect,
+                              &exchange.pretransfer, &exchange.starttransfer, &exchange.total}) {
+            *timer /= speed;
+        }
+        exchange.elapsed_ms /= speed;
+        std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64_t>(exchange.elapsed_ms * 1e3)));
+    }
+    return exchange;
+}
+
+void close(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (mode == Mode::Record) {
+        out_file.close();
+        out << "Recorded " << recorded << " RPC exchange(s) to " << cassette_path << "\n";
+    } else if (mode == Mode::Replay) {
+        out << "Replayed " << hits << " RPC exchange(s) from " << cassette_path;
+        if (misses > 0) {
+            out << "; " << misses << " request(s) had no recording";
+        }
+        out << "\n";
+    }
+    mode = Mode::Off;
+}
+
+} // namespace Cassette
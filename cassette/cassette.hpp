@@ -0,0 +1,93 @@
+#ifndef CASSETTE_HPP
+#define CASSETTE_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * One HTTP exchange with an RPC endpoint, as the transport saw it
+ */
+struct HttpExchange {
+    std::string response;       // body
+    int exit_code = 0;          // curl exit code (28: timeout)
+    int http_code = 0;          // 0 when no response arrived
+    // curl's timers, cumulative from the start of the transfer, in seconds
+    double namelookup = 0.0;
+    double connect = 0.0;
+    double appconnect = 0.0;
+    double pretransfer = 0.0;
+    double starttransfer = 0.0;
+    double total = 0.0;
+    uint64_t bytes_sent = 0;
+    uint64_t bytes_received = 0;
+    double elapsed_ms = 0.0;    // wall time of the whole exchange
+};
+
+/**
+ * Record-and-replay of RPC traffic
+ *
+ * Recording appends every exchange to <dir>/rpc.cassette and copies the
+ * chain registry to <dir>/rpcs.json. Replaying answers each JSON-RPC call
+ * with the recording for the same URL, method and params (in recorded
+ * order, the last one repeating); batches are split into their calls when
+ * loading and reassembled when replaying, so they need not be composed as
+ * they were recorded. The answer comes after the slowest call's recorded
+ * latency divided by the speed. A request with any call lacking a
+ * recording fails like a refused connection.
+ *
+ * File format (host byte order): the 8-byte magic "RPCCAS01", then
+ * records starting with a type byte:
+ *   1  URL       u32 id, u16 length, bytes (each URL is written once)
+ *   2  EXCHANGE  u32 URL id, u64 start (us since recording began),
+ *                u32 elapsed us, u16 HTTP status, u8 curl exit code,
+ *                6 x u32 curl timers in us, u32 bytes sent, u32 bytes
+ *                received, u32 length + request body, u32 length +
+ *                response body
+ */
+namespace Cassette {
+
+constexpr const char* FILE_NAME = "rpc.cassette";
+constexpr const char* REGISTRY_NAME = "rpcs.json";
+
+/**
+ * Start recording into a directory (created if missing)
+ * @return false if the cassette cannot be created
+ */
+bool record_to(const std::string& dir);
+
+/**
+ * Keep a copy of the chain registry next to the recording (no-op unless recording)
+ * @param registry_path rpcs.json the run loaded
+ */
+void save_registry(const std::string& registry_path);
+
+/**
+ * Load a recording and serve requests from it
+ * @param speed Latency divisor: 1 replays the original timing, 10 ten times
+ *              faster, 0 without any delay
+ * @return false if the cassette is missing or malformed
+ */
+bool replay_from(const std::string& dir, double speed = 1.0);
+
+bool recording();
+bool replaying();
+
+/**
+ * Append an exchange to the recording (no-op unless recording)
+ */
+void record(const std::string& url, const std::string& request, const HttpExchange& exchange);
+
+/**
+ * Answer a request from the recording, waiting out its latency
+ */
+HttpExchange replay(const std::string& url, const std::string& request);
+
+/**
+ * Flush the recording and print what was recorded or replayed
+ */
+void close(std::ostream& out);
+
+} // namespace Cassette
+
+#endif // CASSETTE_HPP
@@ -1,23 +1,241 @@
 #include "chain.hpp"
+#include "snapshot.hpp"
 #include <algorithm>
 #include <cctype>
 #include <filesystem>
 #include <cstdlib>
 #include <iostream>
+#include <atomic>
+#include <mutex>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 
-#include <fstream>
-#include "model/chain_model.hpp"
+#include "../include/json.hpp"
 
 // Using nlohmann::json
 using json = nlohmann::json;
 
 static std::vector<Chain> current_chains;
 
+// While the registry comes from a snapshot, chains are decoded on first use of get_all()
+static std::mutex decode_mutex;
+static std::atomic<bool> chains_decoded{true};
+
+namespace {
+
+/**
+ * SAX handler filling Chain records straight from chainlist.org's rpcs.json
+ *
+ * Only name, chainId, isTestnet, infoURL, nativeCurrency.symbol/decimals,
+ * rpc[].url and explorers[0].url are copied; every other value (icons,
+ * tracking, extra explorers, ...) is skipped as the lexer passes over it.
+ * Defaults match the chainlist model: name "Unknown", symbol "ETH",
+ * 18 decimals, and infoURL when there is no explorer.
+ */
+class RegistryReader {
+public:
+    explicit RegistryReader(std::vector<Chain>& chains) : chains_(chains) {}
+
+    bool null() { return true; }
+    bool boolean(bool value) {
+        if (top() == Scope::Chain && field_ == Field::IsTestnet) chain_.is_testnet = value;
+        return true;
+    }
+    bool number_integer(json::number_integer_t value) {
+        return number(value >= 0 ? static_cast<uint64_t>(value) : 0, value >= 0);
+    }
+    bool number_unsigned(json::number_unsigned_t value) { return number(value, true); }
+    bool number_float(json::number_float_t, const json::string_t&) { return true; }
+    bool binary(json::binary_t&) { return true; }
+
+    bool string(json::string_t& value) {
+        switch (top()) {
+            case Scope::Chain:
+                if (field_ == Field::Name) chain_.name = value;
+                else if (field_ == Field::InfoUrl) info_url_ = value;
+                break;
+            case Scope::Currency:
+                if (field_ == Field::Symbol) chain_.symbol = value;
+                break;
+            case Scope::Rpcs:       // a bare URL instead of an {"url": ...} object
+            case Scope::Rpc:
+                if ((top() == Scope::Rpcs || field_ == Field::Url) && !value.empty()) {
+                    chain_.rpc_urls.push_back(value);
+                }
+                break;
+            case Scope::Explorer:
+                if (field_ == Field::Url) chain_.explorer_url = value;
+                break;
+            default:
+                break;
+        }
+        return true;
+    }
+
+    bool key(json::string_t& name) {
+        field_ = Field::Other;
+        switch (top()) {
+            case Scope::Chain:
+                if (name == "name") field_ = Field::Name;
+                else if (name == "chainId") field_ = Field::ChainId;
+                else if (name == "isTestnet") field_ = Field::IsTestnet;
+                else if (name == "infoURL") field_ = Field::InfoUrl;
+                else if (name == "rpc") field_ = Field::Rpc;
+                else if (name == "explorers") field_ = Field::Explorers;
+                else if (name == "nativeCurrency") field_ = Field::Currency;
+                break;
+            case Scope::Currency:
+                if (name == "symbol") field_ = Field::Symbol;
+                else if (name == "decimals") field_ = Field::Decimals;
+                break;
+            case Scope::Rpc:
+            case Scope::Explorer:
+                if (name == "url") field_ = Field::Url;
+                break;
+            default:
+                break;
+        }
+        return true;
+    }
+
+    bool start_object(std::size_t) {
+        Scope scope = Scope::Skip;
+        switch (top()) {
+            case Scope::Root:
+                scope = Scope::Chain;
+                begin_chain();
+                break;
+            case Scope::Chain:
+                if (field_ == Field::Currency) scope = Scope::Currency;
+                break;
+            case Scope::Rpcs:
+                scope = Scope::Rpc;
+                break;
+            case Scope::Explorers:
+                // Only the first explorer is used
+                scope = explorers_++ == 0 ? Scope::Explorer : Scope::Skip;
+                break;
+            default:
+                break;
+        }
+        return push(scope);
+    }
+
+    bool end_object() {
+        if (top() == Scope::Chain) end_chain();
+        scopes_.pop_back();
+        field_ = Field::Other;
+        return true;
+    }
+
+    bool start_array(std::size_t) {
+        Scope scope = Scope::Skip;
+        if (scopes_.empty()) {
+            scope = Scope::Root;
+            found_root_ = true;
+        } else if (top() == Scope::Chain && field_ == Field::Rpc) {
+            scope = Scope::Rpcs;
+            chain_.rpc_urls.clear();
+        } else if (top() == Scope::Chain && field_ == Field::Explorers) {
+            scope = Scope::Explorers;
+            explorers_ = 0;
+            chain_.explorer_url.clear();
+        } else if (top() == Scope::Explorers) {
+            explorers_++;
+        }
+        return push(scope);
+    }
+
+    bool end_array() {
+        scopes_.pop_back();
+        field_ = Field::Other;
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& e) {
+        error_ = e.what();
+        return false;
+    }
+
+    // Set when parsing stopped early
+    const std::string& error() const { return error_; }
+
+    // False if the document was a scalar rather than the array of chains
+    bool found_root() const { return found_root_; }
+
+private:
+    enum class Scope : uint8_t { Root, Chain, Currency, Rpcs, Rpc, Explorers, Explorer, Skip };
+    enum class Field : uint8_t { Other, Name, ChainId, IsTestnet, InfoUrl, Rpc, Explorers, Currency,
+                                 Symbol, Decimals, Url };
+
+    Scope top() const { return scopes_.empty() ? Scope::Skip : scopes_.back(); }
+
+    bool push(Scope scope) {
+        // The registry is an array of chain objects
+        if (scopes_.empty() && scope != Scope::Root) {
+            error_ = "expected an array of chains";
+            return false;
+        }
+        scopes_.push_back(scope);
+        field_ = Field::Other;
+        return true;
+    }
+
+    bool number(uint64_t value, bool valid) {
+        if (top() == Scope::Chain && field_ == Field::ChainId) {
+            chain_.chain_id = value;
+        } else if (top() == Scope::Currency && field_ == Field::Decimals) {
+            decimals_ = valid ? value : UINT64_MAX;
+        }
+        return true;
+    }
+
+    void begin_chain() {
+        chain_ = Chain{};
+        chain_.chain_id = 0;
+        chain_.name = "Unknown";
+        chain_.decimals = 18;
+        chain_.is_testnet = false;
+        info_url_.clear();
+        decimals_ = 18;
+        explorers_ = 0;
+    }
+
+    void end_chain() {
+        if (chain_.chain_id == 0) return;
+        if (chain_.symbol.empty()) chain_.symbol = "ETH";
+        // A 256-bit balance has at most 78 digits
+        chain_.decimals = decimals_ <= 77 ? static_cast<int>(decimals_) : 18;
+        // Prefer the first explorer, fall back to infoURL
+        if (explorers_ == 0) chain_.explorer_url = std::move(info_url_);
+        chains_.push_back(std::move(chain_));
+    }
+
+    std::vector<Chain>& chains_;
+    std::vector<Scope> scopes_;
+    Field field_ = Field::Other;
+    Chain chain_{};
+    std::string info_url_;
+    uint64_t decimals_ = 18;
+    size_t explorers_ = 0;
+    bool found_root_ = false;
+    std::string error_;
+};
+
+} // anonymous namespace
+
 namespace ChainRegistry {
 
 std::optional<Chain> get_by_id(uint64_t chain_id) {
+    if (!chains_decoded) {
+        auto index = RegistrySnapshot::find_id(chain_id);
+        if (!index) return std::nullopt;
+        return RegistrySnapshot::decode(*index);
+    }
     for (const auto& chain : current_chains) {
         if (chain.chain_id == chain_id) {
             return chain;
@@ -27,6 +245,12 @@ std::optional<Chain> get_by_id(uint64_t chain_id) {
 }
 
 std::optional<Chain> get_by_name(const std::string& name) {
+    if (!chains_decoded) {
+        auto index = RegistrySnapshot::find_name(name);
+        if (!index) return std::nullopt;
+        return RegistrySnapshot::decode(*index);
+    }
+    
     auto to_lower = [](std::string s) {
         std::transform(s.begin(), s.end(), s.begin(), ::tolower);
         return s;
@@ -43,16 +267,59 @@ std::optional<Chain> get_by_name(const std::string& name) {
 }
 
 const std::vector<Chain>& get_all() {
+    std::lock_guard<std::mutex> lock(decode_mutex);
+    if (!chains_decoded) {
+        current_chains = RegistrySnapshot::decode_all();
+        chains_decoded = true;
+    }
     return current_chains;
 }
 
 size_t count() {
-    return current_chains.size();
+    return chains_decoded ? current_chains.size() : RegistrySnapshot::count();
+}
+
+bool load(const std::string& path) {
+    // Map the file and parse it in place; the DOM and the chainlist model are never built
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    madvise(addr, size, MADV_SEQUENTIAL);
+    
+    std::vector<Chain> chains;
+    RegistryReader reader(chains);
+    const char* text = static_cast<const char*>(addr);
+    bool ok = json::sax_parse(text, text + size, &reader);
+    munmap(addr, size);
+    if (!ok || !reader.found_root()) {
+        std::cerr << "Error initializing chain registry: "
+                  << (ok ? "expected an array of chains" : reader.error()) << "\n";
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(decode_mutex);
+    RegistrySnapshot::close();
+    chains_decoded = true;
+    current_chains = std::move(chains);
+    return true;
 }
 
 void init(bool force_update) {
     fs::path data_dir = "data";
     fs::path rpcs_file = data_dir / "rpcs.json";
+    bool fetched = false;
     
     // Create data directory
     try {
@@ -66,6 +333,7 @@ void init(bool force_update) {
             std::cout << "Fetching RPCs from chainlist.org...\n";
             std::string cmd = "curl -s https://chainlist.org/rpcs.json -o " + rpcs_file.string();
             int ret = std::system(cmd.c_str());
+            fetched = true;
             
             if (ret != 0) {
                 std::cerr << "Warning: Failed to fetch RPCs. Check your internet connection or curl installation.\n";
@@ -73,48 +341,27 @@ void init(bool force_update) {
                 std::cout << "RPCs saved to " << rpcs_file << "\n";
             }
         }
-        
-        // Load chains from JSON using Model
-        if (fs::exists(rpcs_file)) {
-            std::ifstream f(rpcs_file);
-            json data = json::parse(f);
-            
-            // Deserialize into model
-            auto configs = data.get<std::vector<Model::ChainConfig>>();
-            
-            current_chains.clear();
-            current_chains.reserve(configs.size());
-            
-            for (const auto& config : configs) {
-                if (config.chainId == 0) continue;
-
-                Chain chain;
-                chain.chain_id = config.chainId;
-                chain.name = config.name;
-                chain.symbol = config.nativeCurrency.symbol.empty() ? "ETH" : config.nativeCurrency.symbol;
-                chain.is_testnet = config.isTestnet;
-                
-                // Map RPCs
-                for (const auto& rpc : config.rpc) {
-                    if (!rpc.url.empty()) {
-                        chain.rpc_urls.push_back(rpc.url);
-                    }
-                }
-                
-                // Map Explorer (prefer first one, fallback to infoURL)
-                if (!config.explorers.empty()) {
-                    chain.explorer_url = config.explorers[0].url;
-                } else {
-                    chain.explorer_url = config.infoURL;
-                }
-                
-                current_chains.push_back(chain);
-            }
-        }
-        
     } catch (const std::exception& e) {
         std::cerr << "Error initializing chain registry: " << e.what() << "\n";
     }
+    
+    auto source = RegistrySnapshot::source_of(rpcs_file.string());
+    if (!source) {
+        return;
+    }
+    
+    // The snapshot compiled from this rpcs.json skips the JSON parse entirely
+    if (!fetched && RegistrySnapshot::open(RegistrySnapshot::DEFAULT_PATH, *source)) {
+        std::lock_guard<std::mutex> lock(decode_mutex);
+        current_chains.clear();
+        chains_decoded = false;
+        return;
+    }
+    
+    // Load chains from JSON using Model, then compile them for the next start
+    if (load(rpcs_file.string())) {
+        RegistrySnapshot::write(RegistrySnapshot::DEFAULT_PATH, current_chains, *source);
+    }
 }
 
 } // namespace ChainRegistry
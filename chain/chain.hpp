@@ -10,6 +10,7 @@ struct Chain {
     uint64_t chain_id;
     std::string name;
     std::string symbol;
+    int decimals;  // native currency decimals
     std::vector<std::string> rpc_urls;
     std::string explorer_url;
     bool is_testnet;
@@ -36,6 +37,13 @@ namespace ChainRegistry {
      */
     size_t count();
 
+    /**
+     * Replace the registry with the chains of an rpcs.json file
+     * @param path chainlist.org rpcs.json
+     * @return false if the file is missing or malformed (registry unchanged)
+     */
+    bool load(const std::string& path);
+
     /**
      * Initialize chain registry (fetch RPCs)
      * @param force_update If true, force download of RPCs even if file exists
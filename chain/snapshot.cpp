@@ -0,0 +1,334 @@
+#include "snapshot.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char MAGIC[8] = {'C', 'K', 'R', 'E', 'G', 'B', 'I', 'N'};
+constexpr uint32_t VERSION = 1;
+
+constexpr uint8_t FLAG_TESTNET = 1;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t chains;
+    uint64_t source_size;       // rpcs.json the snapshot was compiled from
+    int64_t source_mtime_ns;
+    uint32_t urls;
+    uint32_t strings_size;
+    uint64_t reserved[4];
+};
+
+// One chain; strings are offsets into the string table
+struct Record {
+    uint64_t chain_id;
+    uint32_t name;
+    uint32_t symbol;
+    uint32_t explorer;
+    uint32_t first_url;         // into the URL table
+    uint16_t url_count;
+    uint8_t decimals;
+    uint8_t flags;
+    uint32_t reserved;
+};
+
+struct IndexEntry {
+    uint64_t chain_id;
+    uint64_t record;
+};
+
+static_assert(sizeof(Header) == 72, "snapshot header layout");
+static_assert(sizeof(Record) == 32, "snapshot record layout");
+static_assert(sizeof(IndexEntry) == 16, "snapshot index layout");
+
+// File layout: Header, Record[chains], IndexEntry[chains], uint32_t urls[urls]
+// (padded to 8 bytes), then the string table of u16 length + bytes entries
+size_t records_offset() {
+    return sizeof(Header);
+}
+
+size_t index_offset(const Header& h) {
+    return records_offset() + h.chains * sizeof(Record);
+}
+
+size_t urls_offset(const Header& h) {
+    return index_offset(h) + h.chains * sizeof(IndexEntry);
+}
+
+size_t strings_offset(const Header& h) {
+    return (urls_offset(h) + h.urls * sizeof(uint32_t) + 7) & ~size_t(7);
+}
+
+std::mutex map_mutex;
+void* mapping = nullptr;
+size_t mapping_size = 0;
+const Header* header = nullptr;
+const Record* records = nullptr;
+const IndexEntry* id_index = nullptr;
+const uint32_t* urls = nullptr;
+const char* strings = nullptr;
+
+std::string_view string_at(uint32_t offset) {
+    uint16_t length;
+    std::memcpy(&length, strings + offset, sizeof(length));
+    return std::string_view(strings + offset + sizeof(length), length);
+}
+
+bool string_valid(uint32_t offset, uint32_t strings_size) {
+    if (static_cast<uint64_t>(offset) + sizeof(uint16_t) > strings_size) return false;
+    uint16_t length;
+    std::memcpy(&length, strings + offset, sizeof(length));
+    return static_cast<uint64_t>(offset) + sizeof(length) + length <= strings_size;
+}
+
+void unmap() {
+    if (mapping) {
+        munmap(mapping, mapping_size);
+    }
+    mapping = nullptr;
+    mapping_size = 0;
+    header = nullptr;
+    records = nullptr;
+    id_index = nullptr;
+    urls = nullptr;
+    strings = nullptr;
+}
+
+// Check every offset once so lookups can trust them
+bool validate() {
+    if (mapping_size < sizeof(Header) || std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header->version != VERSION) {
+        return false;
+    }
+    uint64_t end = strings_offset(*header) + static_cast<uint64_t>(header->strings_size);
+    if (header->chains > mapping_size / sizeof(Record) || header->urls > mapping_size / sizeof(uint32_t) ||
+        end != mapping_size) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header->chains; i++) {
+        const Record& r = records[i];
+        if (!string_valid(r.name, header->strings_size) || !string_valid(r.symbol, header->strings_size) ||
+            !string_valid(r.explorer, header->strings_size) ||
+            static_cast<uint64_t>(r.first_url) + r.url_count > header->urls ||
+            id_index[i].record >= header->chains || (i > 0 && id_index[i - 1].chain_id > id_index[i].chain_id)) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header->urls; i++) {
+        if (!string_valid(urls[i], header->strings_size)) return false;
+    }
+    return true;
+}
+
+template <typename T>
+void put(std::string& buf, const T& value) {
+    buf.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+} // anonymous namespace
+
+namespace RegistrySnapshot {
+
+std::optional<Source> source_of(const std::string& json_path) {
+    struct stat st;
+    if (stat(json_path.c_str(), &st) != 0) {
+        return std::nullopt;
+    }
+    Source source;
+    source.size = static_cast<uint64_t>(st.st_size);
+    source.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    return source;
+}
+
+bool write(const std::string& path, const std::vector<Chain>& chains, const Source& source) {
+    // String table, with repeated strings (symbols, shared URLs) stored once
+    std::string table;
+    std::unordered_map<std::string_view, uint32_t> seen;
+    auto intern = [&table, &seen](std::string_view s) {
+        s = s.substr(0, UINT16_MAX);
+        auto found = seen.find(s);
+        if (found != seen.end()) {
+            return found->second;
+        }
+        uint32_t offset = static_cast<uint32_t>(table.size());
+        uint16_t length = static_cast<uint16_t>(s.size());
+        table.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        table.append(s);
+        seen.emplace(s, offset);
+        return offset;
+    };
+
+    std::vector<Record> recs;
+    std::vector<uint32_t> url_table;
+    recs.reserve(chains.size());
+    for (const Chain& chain : chains) {
+        Record r{};
+        r.chain_id = chain.chain_id;
+        r.name = intern(chain.name);
+        r.symbol = intern(chain.symbol);
+        r.explorer = intern(chain.explorer_url);
+        r.first_url = static_cast<uint32_t>(url_table.size());
+        r.url_count = static_cast<uint16_t>(std::min<size_t>(chain.rpc_urls.size(), UINT16_MAX));
+        for (size_t i = 0; i < r.url_count; i++) {
+            url_table.push_back(intern(chain.rpc_urls[i]));
+        }
+        r.decimals = static_cast<uint8_t>(chain.decimals);
+        r.flags = chain.is_testnet ? FLAG_TESTNET : 0;
+        recs.push_back(r);
+    }
+    if (table.size() > UINT32_MAX) {
+        return false;
+    }
+
+    // Sorted by ID; stable, so duplicate IDs resolve to the first chain like a linear search
+    std::vector<IndexEntry> idx(recs.size());
+    for (size_t i = 0; i < recs.size(); i++) {
+        idx[i] = IndexEntry{recs[i].chain_id, i};
+    }
+    std::stable_sort(idx.begin(), idx.end(), [](const IndexEntry& a, const IndexEntry& b) {
+        return a.chain_id < b.chain_id;
+    });
+
+    Header h{};
+    std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = VERSION;
+    h.chains = static_cast<uint32_t>(recs.size());
+    h.source_size = source.size;
+    h.source_mtime_ns = source.mtime_ns;
+    h.urls = static_cast<uint32_t>(url_table.size());
+    h.strings_size = static_cast<uint32_t>(table.size());
+
+    std::string buf;
+    buf.reserve(strings_offset(h) + table.size());
+    put(buf, h);
+    for (const Record& r : recs) put(buf, r);
+    for (const IndexEntry& e : idx) put(buf, e);
+    for (uint32_t u : url_table) put(buf, u);
+    buf.resize(strings_offset(h), '\0');
+    buf += table;
+
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.write(buf.data(), static_cast<std::streamsize>(buf.size()))) {
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+bool open(const std::string& path, const Source& expected) {
+    std::lock_guard<std::mutex> lock(map_mutex);
+    unmap();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Header))) {
+        ::close(fd);
+        return false;
+    }
+    void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+
+    mapping = addr;
+    mapping_size = static_cast<size_t>(st.st_size);
+    const char* base = static_cast<const char*>(addr);
+    header = reinterpret_cast<const Header*>(base);
+    if (header->chains > mapping_size || header->urls > mapping_size) {
+        unmap();
+        return false;
+    }
+    records = reinterpret_cast<const Record*>(base + records_offset());
+    id_index = reinterpret_cast<const IndexEntry*>(base + index_offset(*header));
+    urls = reinterpret_cast<const uint32_t*>(base + urls_offset(*header));
+    strings = base + strings_offset(*header);
+
+    if (!validate() || header->source_size != expected.size || header->source_mtime_ns != expected.mtime_ns) {
+        unmap();
+        return false;
+    }
+    return true;
+}
+
+void close() {
+    std::lock_guard<std::mutex> lock(map_mutex);
+    unmap();
+}
+
+bool is_open() {
+    return mapping != nullptr;
+}
+
+size_t count() {
+    return header ? header->chains : 0;
+}
+
+Chain decode(size_t i) {
+    const Record& r = records[i];
+    Chain chain;
+    chain.chain_id = r.chain_id;
+    chain.name = string_at(r.name);
+    chain.symbol = string_at(r.symbol);
+    chain.decimals = r.decimals;
+    chain.rpc_urls.reserve(r.url_count);
+    for (uint32_t u = r.first_url; u < r.first_url + r.url_count; u++) {
+        chain.rpc_urls.emplace_back(string_at(urls[u]));
+    }
+    chain.explorer_url = string_at(r.explorer);
+    chain.is_testnet = (r.flags & FLAG_TESTNET) != 0;
+    return chain;
+}
+
+std::vector<Chain> decode_all() {
+    std::vector<Chain> chains;
+    chains.reserve(count());
+    for (size_t i = 0; i < count(); i++) {
+        chains.push_back(decode(i));
+    }
+    return chains;
+}
+
+std::optional<size_t> find_id(uint64_t chain_id) {
+    const IndexEntry* end = id_index + count();
+    const IndexEntry* it = std::lower_bound(id_index, end, chain_id, [](const IndexEntry& e, uint64_t id) {
+        return e.chain_id < id;
+    });
+    if (it == end || it->chain_id != chain_id) {
+        return std::nullopt;
+    }
+    return static_cast<size_t>(it->record);
+}
+
+std::optional<size_t> find_name(std::string_view name) {
+    auto equal = [](char a, char b) {
+        return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+    };
+    for (size_t i = 0; i < count(); i++) {
+        std::string_view candidate = string_at(records[i].name);
+        if (candidate.size() == name.size() && std::equal(candidate.begin(), candidate.end(), name.begin(), equal)) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+} // namespace RegistrySnapshot
@@ -0,0 +1,90 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "chain.hpp"
+
+/**
+ * Compiled, memory-mapped copy of the chain registry (data/rpcs.bin)
+ *
+ * Holds only the fields of Chain, in fixed-size records pointing into a
+ * string table, plus an index sorted by chain ID. Opening it validates
+ * the offsets and maps the file read-only, so startup costs a few
+ * syscalls instead of a JSON parse, and the pages stay shared with the
+ * page cache. The snapshot remembers the size and modification time of
+ * the rpcs.json it was compiled from and is ignored once they change.
+ */
+namespace RegistrySnapshot {
+
+constexpr const char* DEFAULT_PATH = "data/rpcs.bin";
+
+/**
+ * Identity of the rpcs.json a snapshot was compiled from
+ */
+struct Source {
+    uint64_t size = 0;
+    int64_t mtime_ns = 0;
+};
+
+/**
+ * Stat a registry file
+ * @return std::nullopt if it does not exist
+ */
+std::optional<Source> source_of(const std::string& json_path);
+
+/**
+ * Compile chains into a snapshot file (written to a temporary file and renamed)
+ * @param source Identity of the rpcs.json the chains were loaded from
+ * @return false if the file cannot be written
+ */
+bool write(const std::string& path, const std::vector<Chain>& chains, const Source& source);
+
+/**
+ * Map a snapshot, replacing the one mapped before
+ * @param expected Identity of the current rpcs.json
+ * @return false if the file is missing, malformed or compiled from another rpcs.json
+ */
+bool open(const std::string& path, const Source& expected);
+
+/**
+ * Unmap the snapshot
+ */
+void close();
+
+/**
+ * Check if a snapshot is mapped
+ */
+bool is_open();
+
+/**
+ * Number of chains in the mapped snapshot
+ */
+size_t count();
+
+/**
+ * Decode one chain, in registry order
+ */
+Chain decode(size_t index);
+
+/**
+ * Decode every chain, in registry order
+ */
+std::vector<Chain> decode_all();
+
+/**
+ * Position of the first chain with an ID (binary search of the index)
+ */
+std::optional<size_t> find_id(uint64_t chain_id);
+
+/**
+ * Position of the first chain with a name (case-insensitive)
+ */
+std::optional<size_t> find_name(std::string_view name);
+
+} // namespace RegistrySnapshot
+
+#endif // SNAPSHOT_HPP
@@ -0,0 +1,363 @@
+#include "daemon.hpp"
+#include "../address/address.hpp"
+#include "../chain/chain.hpp"
+#include "../metrics/metrics.hpp"
+#include "../output/result_sink.hpp"
+#include "../pool/worker_pool.hpp"
+#include "../priority/chain_priority.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace DaemonProtocol;
+
+namespace {
+
+using ChainSet = std::shared_ptr<const std::vector<Chain>>;
+
+volatile std::sig_atomic_t stop_requested = 0;
+
+void on_signal(int) {
+    stop_requested = 1;
+}
+
+// Chains handed to new scans; replaced as a whole after each probe so
+// running scans keep the set they started with
+std::mutex chains_mutex;
+ChainSet current_chains;
+
+ChainSet chains_snapshot() {
+    std::lock_guard<std::mutex> lock(chains_mutex);
+    return current_chains;
+}
+
+void refresh_chains(const DaemonOptions& options) {
+    const auto& all = ChainRegistry::get_all();
+    if (!options.probe_endpoints) {
+        std::lock_guard<std::mutex> lock(chains_mutex);
+        current_chains = std::make_shared<const std::vector<Chain>>(all);
+        return;
+    }
+
+    std::vector<const Chain*> to_probe;
+    for (const auto& chain : all) {
+        to_probe.push_back(&chain);
+    }
+
+    ProbeSummary summary;
+    auto live = std::make_shared<const std::vector<Chain>>(
+        EndpointProbe::prune(to_probe, &summary, options.probe_timeout));
+    std::cout << "Probe: " << summary.alive << "/" << summary.endpoints << " endpoints alive, "
+              << live->size() << " chains usable\n" << std::flush;
+
+    std::lock_guard<std::mutex> lock(chains_mutex);
+    current_chains = live;
+}
+
+bool bind_socket(const std::string& path, int& listen_fd) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Error: Socket path too long: " << path << "\n";
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        std::cerr << "Error: Cannot create socket\n";
+        return false;
+    }
+
+    // A socket file left by a crashed daemon refuses connections
+    int probe_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe_fd >= 0) {
+        bool in_use = connect(probe_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        close(probe_fd);
+        if (in_use) {
+            std::cerr << "Error: A daemon is already listening on " << path << "\n";
+            close(fd);
+            return false;
+        }
+    }
+    unlink(path.c_str());
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+        std::cerr << "Error: Cannot listen on " << path << ": " << std::strerror(errno) << "\n";
+        close(fd);
+        return false;
+    }
+
+    listen_fd = fd;
+    return true;
+}
+
+// Streams each result to the client as a RESULT frame
+class FrameSink : public ResultSink {
+public:
+    explicit FrameSink(int fd) : fd_(fd) {}
+
+    void complete(size_t seq, const ChainResult* result) override {
+        (void)seq;
+        if (!result) return;
+
+        std::string payload = encode_result(*result);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!client_gone_ && !write_frame(fd_, FrameType::Result, payload)) {
+            client_gone_ = true;
+        }
+        count_++;
+    }
+
+    uint32_t count() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return count_;
+    }
+
+private:
+    int fd_;
+    std::mutex mutex_;
+    bool client_gone_ = false;
+    uint32_t count_ = 0;
+};
+
+void handle_scan(int fd, const ScanRequest& request, const DaemonOptions& options) {
+    if (!Address::is_valid(request.address)) {
+        write_frame(fd, FrameType::Error, encode_error("Invalid address format"));
+        return;
+    }
+
+    ChainSet chains = chains_snapshot();
+
+    ScanOptions scan;
+    scan.include_testnets = request.include_testnets;
+    scan.only_with_activity = request.only_with_activity;
+    scan.num_threads = request.threads == 0 ? options.default_threads
+                                            : std::min<size_t>(request.threads, options.max_threads);
+    scan.query.plan = request.proof ? QueryPlan::Proof : QueryPlan::Batch;
+    scan.cache_ttl_blocks = request.cache_ttl_blocks;
+    scan.offline = request.offline;
+    scan.skip_empty = request.skip_empty;
+    scan.reverify_rate = request.reverify_rate;
+    scan.top_k = request.top_k;
+    scan.chains = chains.get();
+    scan.verbose = false;
+
+    FrameSink sink(fd);
+    scan.sink = &sink;
+
+    auto start = std::chrono::steady_clock::now();
+    MultiChainChecker::scan_all(request.address, scan);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    write_frame(fd, FrameType::Done, encode_done(sink.count()));
+    std::cout << "Scan " << request.address << ": " << sink.count() << " chain(s) with activity in "
+              << elapsed << " ms\n" << std::flush;
+}
+
+void serve_client(int fd, DaemonOptions options) {
+    FrameType type;
+    std::string payload;
+    while (read_frame(fd, type, payload)) {
+        if (type == FrameType::Metrics) {
+            std::ostringstream text;
+            Metrics::write_prometheus(text);
+            if (!write_frame(fd, FrameType::Metrics, text.str())) break;
+            continue;
+        }
+        if (type != FrameType::Scan) {
+            write_frame(fd, FrameType::Error, encode_error("Unexpected frame type"));
+            break;
+        }
+
+        auto request = decode_scan(payload);
+        if (!request) {
+            write_frame(fd, FrameType::Error, encode_error("Malformed scan request"));
+            break;
+        }
+        handle_scan(fd, *request, options);
+    }
+    close(fd);
+}
+
+// Connect to a daemon socket, -1 on failure (error set)
+int connect_socket(const std::string& socket_path, std::string& error) {
+    sockaddr_un addr{};
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        error = "Socket path too long";
+        return -1;
+    }
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        if (fd >= 0) close(fd);
+        error = "Cannot connect to daemon at " + socket_path;
+        return -1;
+    }
+    return fd;
+}
+
+} // anonymous namespace
+
+namespace ScanDaemon {
+
+int run(const DaemonOptions& options) {
+    if (ChainRegistry::count() == 0) {
+        std::cerr << "Error: No chains loaded\n";
+        return 1;
+    }
+
+    if (!ResultCache::open()) {
+        std::cerr << "Warning: Running without the result cache\n";
+    }
+    if (!EmptyFilter::open()) {
+        std::cerr << "Warning: Running without the empty filter\n";
+    }
+
+    ChainPriority::load();
+    Metrics::enable();
+    if (!options.metrics_path.empty()) {
+        Metrics::dump_on_signal(options.metrics_path);
+    }
+    refresh_chains(options);
+    MultiChainChecker::init_pool(options.workers > 0 ? options.workers : options.max_threads);
+
+    int listen_fd = -1;
+    if (!bind_socket(options.socket_path, listen_fd)) {
+        return 1;
+    }
+
+    struct sigaction sa{};
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    // Re-probe endpoints in the background
+    std::mutex reprobe_mutex;
+    std::condition_variable reprobe_cv;
+    bool stopping = false;
+    std::thread reprober;
+    if (options.probe_endpoints && options.reprobe_sec > 0) {
+        reprober = std::thread([&]() {
+            std::unique_lock<std::mutex> lock(reprobe_mutex);
+            while (!reprobe_cv.wait_for(lock, std::chrono::seconds(options.reprobe_sec), [&] { return stopping; })) {
+                lock.unlock();
+                refresh_chains(options);
+                lock.lock();
+            }
+        });
+    }
+
+    std::cout << "Daemon listening on " << options.socket_path << " ("
+              << chains_snapshot()->size() << " chains, "
+              << MultiChainChecker::pool()->size() << " workers)\n" << std::flush;
+
+    while (!stop_requested) {
+        pollfd pfd{listen_fd, POLLIN, 0};
+        if (poll(&pfd, 1, 500) <= 0) {
+            continue;
+        }
+
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        std::thread(serve_client, fd, options).detach();
+    }
+
+    std::cout << "\nShutting down\n";
+    close(listen_fd);
+    unlink(options.socket_path.c_str());
+
+    {
+        std::lock_guard<std::mutex> lock(reprobe_mutex);
+        stopping = true;
+    }
+    reprobe_cv.notify_all();
+    if (reprober.joinable()) {
+        reprober.join();
+    }
+    ChainPriority::save();
+    if (!options.metrics_path.empty()) {
+        Metrics::write_file(options.metrics_path);
+    }
+
+    // Client threads may still be scanning, so the cache mappings and the
+    // worker pool are left to go away with the process
+    return 0;
+}
+
+bool request_scan(const std::string& socket_path,
+                  const ScanRequest& request,
+                  const std::function<void(const ChainResult&)>& on_result,
+                  std::string& error) {
+    int fd = connect_socket(socket_path, error);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool done = false;
+    if (!write_frame(fd, FrameType::Scan, encode_scan(request))) {
+        error = "Daemon closed the connection";
+    } else {
+        FrameType type;
+        std::string payload;
+        error = "Daemon closed the connection";
+        while (!done && read_frame(fd, type, payload)) {
+            if (type == FrameType::Result) {
+                auto result = decode_result(payload);
+                if (!result) {
+                    error = "Malformed result frame";
+                    break;
+                }
+                on_result(*result);
+            } else if (type == FrameType::Done) {
+                done = true;
+            } else if (type == FrameType::Error) {
+                error = decode_error(payload).value_or("Malformed error frame");
+                break;
+            } else {
+                error = "Unexpected frame type";
+                break;
+            }
+        }
+    }
+
+    close(fd);
+    return done;
+}
+
+bool request_metrics(const std::string& socket_path, std::string& text, std::string& error) {
+    int fd = connect_socket(socket_path, error);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool ok = false;
+    FrameType type;
+    error = "Daemon closed the connection";
+    if (write_frame(fd, FrameType::Metrics, "") && read_frame(fd, type, text)) {
+        ok = type == FrameType::Metrics;
+        if (!ok) error = "Unexpected frame type";
+    }
+
+    close(fd);
+    return ok;
+}
+
+} // namespace ScanDaemon
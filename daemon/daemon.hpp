@@ -0,0 +1,61 @@
+#ifndef DAEMON_HPP
+#define DAEMON_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "protocol.hpp"
+
+/**
+ * Daemon settings
+ */
+struct DaemonOptions {
+    std::string socket_path = "data/checker.sock";
+    size_t default_threads = 20;        // threads for requests that do not ask for a count
+    size_t max_threads = 100;           // upper bound on threads per request
+    size_t workers = 0;                 // worker pool shared by all requests (0: max_threads)
+    bool probe_endpoints = false;       // keep only endpoints that pass a periodic eth_chainId probe
+    double probe_timeout = EndpointProbe::DEFAULT_TIMEOUT_SEC;
+    uint64_t reprobe_sec = 600;         // interval between probes
+    std::string metrics_path;           // Prometheus file written on SIGUSR1 and at exit (empty: none)
+};
+
+/**
+ * Long-running scanner behind a Unix socket
+ * The chain registry, result cache, empty filter and endpoint probe
+ * results are loaded once and shared by all requests.
+ */
+namespace ScanDaemon {
+
+/**
+ * Serve scan requests until SIGINT or SIGTERM
+ * The chain registry must be initialized.
+ * @return Process exit code
+ */
+int run(const DaemonOptions& options);
+
+/**
+ * Send a scan request to a running daemon
+ * @param socket_path Daemon socket
+ * @param request Scan request
+ * @param on_result Called for each result as it arrives (unordered)
+ * @param error Set when the request fails
+ * @return true if the daemon completed the scan
+ */
+bool request_scan(const std::string& socket_path,
+                  const DaemonProtocol::ScanRequest& request,
+                  const std::function<void(const ChainResult&)>& on_result,
+                  std::string& error);
+
+/**
+ * Fetch the metrics of a running daemon
+ * @param socket_path Daemon socket
+ * @param text Set to the Prometheus text exposition
+ * @param error Set when the request fails
+ * @return true if the daemon answered
+ */
+bool request_metrics(const std::string& socket_path, std::string& text, std::string& error);
+
+} // namespace ScanDaemon
+
+#endif // DAEMON_HPP
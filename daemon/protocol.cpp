@@ -0,0 +1,228 @@
+#include "protocol.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+enum ScanFlags : uint8_t {
+    SCAN_TESTNETS = 1 << 0,
+    SCAN_ONLY_ACTIVE = 1 << 1,
+    SCAN_PROOF = 1 << 2,
+    SCAN_OFFLINE = 1 << 3,
+    SCAN_SKIP_EMPTY = 1 << 4,
+};
+
+enum ResultFlags : uint8_t {
+    RESULT_CONTRACT = 1 << 0,
+    RESULT_ACTIVE = 1 << 1,
+    RESULT_CACHED = 1 << 2,
+};
+
+class Writer {
+public:
+    template <typename T>
+    void put(T value) {
+        out_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void put_string(const std::string& s) {
+        uint16_t len = static_cast<uint16_t>(std::min<size_t>(s.size(), UINT16_MAX));
+        put(len);
+        out_.append(s, 0, len);
+    }
+
+    std::string take() { return std::move(out_); }
+
+private:
+    std::string out_;
+};
+
+class Reader {
+public:
+    explicit Reader(const std::string& in) : in_(in) {}
+
+    template <typename T>
+    bool get(T& value) {
+        if (in_.size() - pos_ < sizeof(value)) return false;
+        std::memcpy(&value, in_.data() + pos_, sizeof(value));
+        pos_ += sizeof(value);
+        return true;
+    }
+
+    bool get_string(std::string& s) {
+        uint16_t len;
+        if (!get(len) || in_.size() - pos_ < len) return false;
+        s.assign(in_, pos_, len);
+        pos_ += len;
+        return true;
+    }
+
+    bool at_end() const { return pos_ == in_.size(); }
+
+private:
+    const std::string& in_;
+    size_t pos_ = 0;
+};
+
+bool write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool read_all(int fd, char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = read(fd, data, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+namespace DaemonProtocol {
+
+std::string encode_scan(const ScanRequest& request) {
+    uint8_t flags = 0;
+    if (request.include_testnets) flags |= SCAN_TESTNETS;
+    if (request.only_with_activity) flags |= SCAN_ONLY_ACTIVE;
+    if (request.proof) flags |= SCAN_PROOF;
+    if (request.offline) flags |= SCAN_OFFLINE;
+    if (request.skip_empty) flags |= SCAN_SKIP_EMPTY;
+
+    Writer w;
+    w.put(VERSION);
+    w.put(flags);
+    w.put(request.threads);
+    w.put(request.cache_ttl_blocks);
+    w.put(request.reverify_rate);
+    w.put(request.top_k);
+    w.put_string(request.address);
+    return w.take();
+}
+
+std::optional<ScanRequest> decode_scan(const std::string& payload) {
+    Reader r(payload);
+    uint8_t version, flags;
+    ScanRequest request;
+    if (!r.get(version) || version != VERSION || !r.get(flags) ||
+        !r.get(request.threads) || !r.get(request.cache_ttl_blocks) ||
+        !r.get(request.reverify_rate) || !r.get(request.top_k) || !r.get_string(request.address) || !r.at_end()) {
+        return std::nullopt;
+    }
+
+    request.include_testnets = flags & SCAN_TESTNETS;
+    request.only_with_activity = flags & SCAN_ONLY_ACTIVE;
+    request.proof = flags & SCAN_PROOF;
+    request.offline = flags & SCAN_OFFLINE;
+    request.skip_empty = flags & SCAN_SKIP_EMPTY;
+    return request;
+}
+
+std::string encode_result(const ChainResult& result) {
+    uint8_t flags = 0;
+    if (result.is_contract) flags |= RESULT_CONTRACT;
+    if (result.has_activity) flags |= RESULT_ACTIVE;
+    if (result.from_cache) flags |= RESULT_CACHED;
+
+    Writer w;
+    w.put(result.chain_id);
+    for (uint64_t limb : result.balance.limbs) {
+        w.put(limb);
+    }
+    w.put(result.tx_count);
+    w.put(result.block_number);
+    w.put(static_cast<int32_t>(result.decimals));
+    w.put(flags);
+    w.put_string(result.chain_name);
+    w.put_string(result.symbol);
+    w.put_string(result.explorer_url);
+    return w.take();
+}
+
+std::optional<ChainResult> decode_result(const std::string& payload) {
+    Reader r(payload);
+    ChainResult result;
+    int32_t decimals;
+    uint8_t flags;
+    bool ok = r.get(result.chain_id);
+    for (uint64_t& limb : result.balance.limbs) {
+        ok = ok && r.get(limb);
+    }
+    ok = ok && r.get(result.tx_count) && r.get(result.block_number) &&
+         r.get(decimals) && r.get(flags) &&
+         r.get_string(result.chain_name) && r.get_string(result.symbol) &&
+         r.get_string(result.explorer_url) && r.at_end();
+    if (!ok) {
+        return std::nullopt;
+    }
+
+    result.decimals = decimals;
+    result.is_contract = flags & RESULT_CONTRACT;
+    result.has_activity = flags & RESULT_ACTIVE;
+    result.from_cache = flags & RESULT_CACHED;
+    return result;
+}
+
+std::string encode_done(uint32_t count) {
+    Writer w;
+    w.put(count);
+    return w.take();
+}
+
+std::string encode_error(const std::string& message) {
+    Writer w;
+    w.put_string(message);
+    return w.take();
+}
+
+std::optional<std::string> decode_error(const std::string& payload) {
+    Reader r(payload);
+    std::string message;
+    if (!r.get_string(message) || !r.at_end()) {
+        return std::nullopt;
+    }
+    return message;
+}
+
+bool write_frame(int fd, FrameType type, const std::string& payload) {
+    // Header and payload go out from one buffer; threads sharing a socket
+    // must still hold a lock around the call
+    std::string frame;
+    frame.reserve(5 + payload.size());
+    uint32_t len = static_cast<uint32_t>(payload.size());
+    frame.append(reinterpret_cast<const char*>(&len), sizeof(len));
+    frame.push_back(static_cast<char>(type));
+    frame.append(payload);
+    return write_all(fd, frame.data(), frame.size());
+}
+
+bool read_frame(int fd, FrameType& type, std::string& payload) {
+    char header[5];
+    if (!read_all(fd, header, sizeof(header))) {
+        return false;
+    }
+
+    uint32_t len;
+    std::memcpy(&len, header, sizeof(len));
+    if (len > MAX_FRAME) {
+        return false;
+    }
+
+    type = static_cast<FrameType>(header[4]);
+    payload.resize(len);
+    return len == 0 || read_all(fd, payload.data(), len);
+}
+
+} // namespace DaemonProtocol
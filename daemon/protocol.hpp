@@ -0,0 +1,76 @@
+#ifndef DAEMON_PROTOCOL_HPP
+#define DAEMON_PROTOCOL_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include "../multi_checker/multi_checker.hpp"
+
+/**
+ * Framed protocol spoken over the daemon's Unix socket
+ *
+ * Every frame is a u32 payload length, a u8 frame type and the payload.
+ * Integers are in host byte order (both ends run on the same machine),
+ * strings are a u16 length followed by the bytes.
+ *
+ *   client -> daemon   SCAN      one request per frame, answered in order
+ *                      METRICS   empty payload
+ *   daemon -> client   RESULT    one per chain with activity, as it completes
+ *                      DONE      u32 result count, ends the answer to a SCAN
+ *                      ERROR     message, ends the answer to a SCAN
+ *                      METRICS   Prometheus text exposition, answers a METRICS
+ */
+namespace DaemonProtocol {
+
+constexpr uint8_t VERSION = 2;
+constexpr uint32_t MAX_FRAME = 1 << 24;  // a metrics exposition covers every chain
+
+enum class FrameType : uint8_t {
+    Scan = 1,
+    Result = 2,
+    Done = 3,
+    Error = 4,
+    Metrics = 5,
+};
+
+/**
+ * Scan request sent by a client
+ */
+struct ScanRequest {
+    std::string address;
+    bool include_testnets = true;
+    bool only_with_activity = true;
+    bool proof = false;
+    bool offline = false;
+    bool skip_empty = false;
+    uint16_t threads = 0;              // 0 = daemon default
+    uint64_t cache_ttl_blocks = ResultCache::DEFAULT_TTL_BLOCKS;
+    double reverify_rate = 0.0;
+    uint32_t top_k = 0;                // 0 = scan every chain
+};
+
+std::string encode_scan(const ScanRequest& request);
+std::optional<ScanRequest> decode_scan(const std::string& payload);
+
+std::string encode_result(const ChainResult& result);
+std::optional<ChainResult> decode_result(const std::string& payload);
+
+std::string encode_done(uint32_t count);
+std::string encode_error(const std::string& message);
+std::optional<std::string> decode_error(const std::string& payload);
+
+/**
+ * Write one frame, retrying on short writes
+ * @return false if the peer is gone
+ */
+bool write_frame(int fd, FrameType type, const std::string& payload);
+
+/**
+ * Read one frame
+ * @return false on EOF, error or an oversized frame
+ */
+bool read_frame(int fd, FrameType& type, std::string& payload);
+
+} // namespace DaemonProtocol
+
+#endif // DAEMON_PROTOCOL_HPP
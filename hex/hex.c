@@ -1,6 +1,12 @@
 #include "hex.h"
 #include <string.h>
 #include <ctype.h>
+#include <stdatomic.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HEX_X86 1
+#endif
 
 bool is_hex_char(char c) {
     return (c >= '0' && c <= '9') ||
@@ -43,19 +49,12 @@ int hex_to_bytes(const char *hex, uint8_t *out, size_t hex_len) {
         return -1;
     }
     
-    /* Check all chars are hex */
-    if (!is_hex_string(start, len)) {
+    /* Validates while decoding */
+    if (!hex_decode(start, len, out)) {
         return -1;
     }
     
-    size_t out_len = len / 2;
-    for (size_t i = 0; i < out_len; i++) {
-        uint8_t high = hex_char_to_nibble(start[i * 2]);
-        uint8_t low = hex_char_to_nibble(start[i * 2 + 1]);
-        out[i] = (uint8_t)((high << 4) | low);
-    }
-    
-    return (int)out_len;
+    return (int)(len / 2);
 }
 
 void bytes_to_hex(const uint8_t *bytes, size_t len, char *out, bool prefix) {
@@ -75,3 +74,201 @@ void bytes_to_hex(const uint8_t *bytes, size_t len, char *out, bool prefix) {
     
     out[offset + len * 2] = '\0';
 }
+
+/* Nibble value + 1 for every hex character, 0 for everything else */
+static const uint8_t nibble_table[256] = {
+    ['0'] = 1,  ['1'] = 2,  ['2'] = 3,  ['3'] = 4,  ['4'] = 5,
+    ['5'] = 6,  ['6'] = 7,  ['7'] = 8,  ['8'] = 9,  ['9'] = 10,
+    ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+    ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+};
+
+static bool hex_decode_scalar(const char *hex, size_t hex_len, uint8_t *out) {
+    bool bad = false;
+    
+    for (size_t i = 0; i < hex_len / 2; i++) {
+        uint8_t high = nibble_table[(uint8_t)hex[i * 2]];
+        uint8_t low = nibble_table[(uint8_t)hex[i * 2 + 1]];
+        
+        bad |= (high == 0) | (low == 0);
+        out[i] = (uint8_t)(((high - 1) << 4) | ((low - 1) & 0x0F));
+    }
+    
+    return !bad;
+}
+
+#ifdef HEX_X86
+
+/*
+ * 16 hex digits -> 8 bytes
+ * Digits and letters are classified with signed compares (bytes >= 0x80 are
+ * negative and fail both ranges), mapped to nibbles with a blend, and adjacent
+ * nibbles are merged with maddubs (high * 16 + low).
+ */
+__attribute__((target("sse4.1")))
+static bool hex_decode_sse41(const char *hex, size_t hex_len, uint8_t *out) {
+    const __m128i digit_lo = _mm_set1_epi8('0' - 1);
+    const __m128i digit_hi = _mm_set1_epi8('9' + 1);
+    const __m128i alpha_lo = _mm_set1_epi8('a' - 1);
+    const __m128i alpha_hi = _mm_set1_epi8('f' + 1);
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    const __m128i merge = _mm_set1_epi16(0x0110);
+    
+    size_t i = 0;
+    for (; i + 16 <= hex_len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(hex + i));
+        __m128i lower = _mm_or_si128(v, case_bit);
+        
+        __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(v, digit_lo), _mm_cmplt_epi8(v, digit_hi));
+        __m128i is_alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, alpha_lo), _mm_cmplt_epi8(lower, alpha_hi));
+        if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha)) != 0xFFFF) {
+            return false;
+        }
+        
+        __m128i digits = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+        __m128i letters = _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10));
+        __m128i nibbles = _mm_blendv_epi8(letters, digits, is_digit);
+        
+        __m128i bytes = _mm_maddubs_epi16(nibbles, merge);
+        _mm_storel_epi64((__m128i *)(out + i / 2), _mm_packus_epi16(bytes, bytes));
+    }
+    
+    return hex_decode_scalar(hex + i, hex_len - i, out + i / 2);
+}
+
+/* 32 hex digits -> 16 bytes, same scheme as the SSE4.1 path */
+__attribute__((target("avx2")))
+static bool hex_decode_avx2(const char *hex, size_t hex_len, uint8_t *out) {
+    const __m256i digit_lo = _mm256_set1_epi8('0' - 1);
+    const __m256i digit_hi = _mm256_set1_epi8('9' + 1);
+    const __m256i alpha_lo = _mm256_set1_epi8('a' - 1);
+    const __m256i alpha_hi = _mm256_set1_epi8('f' + 1);
+    const __m256i case_bit = _mm256_set1_epi8(0x20);
+    const __m256i merge = _mm256_set1_epi16(0x0110);
+    
+    size_t i = 0;
+    for (; i + 32 <= hex_len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(hex + i));
+        __m256i lower = _mm256_or_si256(v, case_bit);
+        
+        __m256i is_digit = _mm256_and_si256(_mm256_cmpgt_epi8(v, digit_lo), _mm256_cmpgt_epi8(digit_hi, v));
+        __m256i is_alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, alpha_lo), _mm256_cmpgt_epi8(alpha_hi, lower));
+        if ((uint32_t)_mm256_movemask_epi8(_mm256_or_si256(is_digit, is_alpha)) != 0xFFFFFFFFu) {
+            return false;
+        }
+        
+        __m256i digits = _mm256_sub_epi8(v, _mm256_set1_epi8('0'));
+        __m256i letters = _mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10));
+        __m256i nibbles = _mm256_blendv_epi8(letters, digits, is_digit);
+        
+        /* packus works per 128-bit lane: gather qwords 0 and 2 */
+        __m256i bytes = _mm256_maddubs_epi16(nibbles, merge);
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(bytes, bytes), 0x08);
+        _mm_storeu_si128((__m128i *)(out + i / 2), _mm256_castsi256_si128(packed));
+    }
+    
+    return hex_decode_sse41(hex + i, hex_len - i, out + i / 2);
+}
+
+#endif /* HEX_X86 */
+
+typedef bool (*hex_decode_fn)(const char *, size_t, uint8_t *);
+
+static hex_decode_fn select_decoder(void) {
+#ifdef HEX_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return hex_decode_avx2;
+    if (__builtin_cpu_supports("sse4.1")) return hex_decode_sse41;
+#endif
+    return hex_decode_scalar;
+}
+
+bool hex_decode(const char *hex, size_t hex_len, uint8_t *out) {
+    /* Atomic so pool threads may race on the first call: each resolves to the
+     * same function, and relaxed order suffices for a pointer to static code */
+    static _Atomic(hex_decode_fn) decoder = NULL;
+    
+    if (hex_len % 2 != 0) {
+        return false;
+    }
+    hex_decode_fn fn = atomic_load_explicit(&decoder, memory_order_relaxed);
+    if (fn == NULL) {
+        fn = select_decoder();
+        atomic_store_explicit(&decoder, fn, memory_order_relaxed);
+    }
+    
+    return fn(hex, hex_len, out);
+}
+
+/* Skip an optional 0x prefix without relying on NUL termination */
+static size_t prefix_len(const char *str, size_t len) {
+    return (len >= 2 && str[0] == '0' && (str[1] == 'x' || str[1] == 'X')) ? 2 : 0;
+}
+
+int hex_decode_data(const char *str, size_t len, uint8_t *out, size_t out_cap) {
+    size_t skip = prefix_len(str, len);
+    str += skip;
+    len -= skip;
+    
+    if (len % 2 != 0 || len / 2 > out_cap) {
+        return -1;
+    }
+    if (!hex_decode(str, len, out)) {
+        return -1;
+    }
+    
+    return (int)(len / 2);
+}
+
+bool hex_decode_quantity(const char *str, size_t len, uint64_t *limbs, size_t nlimbs) {
+    size_t skip = prefix_len(str, len);
+    str += skip;
+    len -= skip;
+    
+    if (len == 0) {
+        return false;
+    }
+    
+    /* Leading zeros are not canonical but some nodes send them */
+    while (len > 1 && str[0] == '0') {
+        str++;
+        len--;
+    }
+    
+    if (len > nlimbs * 16) {
+        return false;
+    }
+    
+    /* Each limb is the 16 digits ending at its position */
+    for (size_t i = 0; i < nlimbs; i++) {
+        limbs[i] = 0;
+        if (i * 16 >= len) continue;
+        
+        size_t end = len - i * 16;
+        
+        /* Partial top limb: too short for the vector path */
+        if (end < 16) {
+            uint64_t value = 0;
+            for (size_t j = 0; j < end; j++) {
+                uint8_t nibble = nibble_table[(uint8_t)str[j]];
+                if (nibble == 0) {
+                    return false;
+                }
+                value = (value << 4) | (uint64_t)(nibble - 1);
+            }
+            limbs[i] = value;
+            continue;
+        }
+        
+        uint8_t be[8];
+        if (!hex_decode(str + end - 16, 16, be)) {
+            return false;
+        }
+        
+        for (size_t b = 0; b < 8; b++) {
+            limbs[i] = (limbs[i] << 8) | be[b];
+        }
+    }
+    
+    return true;
+}
@@ -47,6 +47,37 @@ int hex_to_bytes(const char *hex, uint8_t *out, size_t hex_len);
  */
 void bytes_to_hex(const uint8_t *bytes, size_t len, char *out, bool prefix);
 
+/**
+ * Decode hex digits to bytes, validating every character
+ * Uses AVX2 or SSE4.1 when the CPU supports them, scalar code otherwise.
+ * @param hex Hex digits without 0x prefix
+ * @param hex_len Number of digits (must be even)
+ * @param out Output buffer (must be at least hex_len/2 bytes)
+ * @return true if all characters were hex digits
+ */
+bool hex_decode(const char *hex, size_t hex_len, uint8_t *out);
+
+/**
+ * Decode a hex data string (e.g., "0x00ff", prefix optional) to bytes
+ * @param str Input string (need not be NUL-terminated)
+ * @param len Length of str
+ * @param out Output buffer
+ * @param out_cap Size of out
+ * @return Number of bytes written, or -1 if invalid, odd length or too long
+ */
+int hex_decode_data(const char *str, size_t len, uint8_t *out, size_t out_cap);
+
+/**
+ * Decode a hex quantity (e.g., "0x1a", prefix optional, odd length allowed)
+ * into little-endian 64-bit limbs
+ * @param str Input string (need not be NUL-terminated)
+ * @param len Length of str
+ * @param limbs Output limbs, least significant first (undefined on failure)
+ * @param nlimbs Number of limbs
+ * @return true on success, false if empty, not hex or wider than nlimbs * 64 bits
+ */
+bool hex_decode_quantity(const char *str, size_t len, uint64_t *limbs, size_t nlimbs);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,201 @@
+#include "address_input.hpp"
+#include "bounded_queue.hpp"
+#include "../address/address.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t READ_CHUNK = 64 * 1024;
+constexpr size_t MAP_WINDOW = 4 * 1024 * 1024;  // multiple of the page size
+constexpr size_t MAX_TOKEN = 256;   // longer runs are not addresses; keep memory bounded
+
+// Splits a byte stream into tokens across chunk boundaries
+class Tokenizer {
+public:
+    explicit Tokenizer(const std::function<bool(const std::string&, size_t)>& on_token)
+        : on_token_(on_token) {}
+
+    bool feed(const char* data, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            char c = data[i];
+            if (c == '\n') {
+                if (!emit()) return false;
+                in_comment_ = false;
+                line_++;
+            } else if (in_comment_) {
+                continue;
+            } else if (c == '#') {
+                if (!emit()) return false;
+                in_comment_ = true;
+            } else if (c == ' ' || c == '\t' || c == '\r' || c == ',' || c == ';') {
+                if (!emit()) return false;
+            } else {
+                if (token_.empty()) token_line_ = line_;
+                if (token_.size() < MAX_TOKEN) token_ += c;
+            }
+        }
+        return true;
+    }
+
+    bool finish() {
+        return emit();
+    }
+
+private:
+    bool emit() {
+        if (token_.empty()) return true;
+        bool more = on_token_(token_, token_line_);
+        token_.clear();
+        return more;
+    }
+
+    const std::function<bool(const std::string&, size_t)>& on_token_;
+    std::string token_;
+    size_t line_ = 1;
+    size_t token_line_ = 1;
+    bool in_comment_ = false;
+};
+
+bool has_mixed_case(const std::string& address) {
+    bool upper = false, lower = false;
+    for (size_t i = 2; i < address.size(); i++) {
+        char c = address[i];
+        if (c >= 'A' && c <= 'F') upper = true;
+        if (c >= 'a' && c <= 'f') lower = true;
+    }
+    return upper && lower;
+}
+
+struct Token {
+    std::string text;
+    size_t line;
+};
+
+} // anonymous namespace
+
+namespace AddressInput {
+
+bool for_each_token(const std::string& path,
+                    const std::function<bool(const std::string&, size_t)>& on_token) {
+    int fd = path == "-" ? STDIN_FILENO : ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Error: Cannot open " << path << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    Tokenizer tokenizer(on_token);
+    bool ok = true;
+
+    // Regular files are mapped; the kernel pages them in and out as the
+    // tokenizer walks forward
+    struct stat st;
+    void* map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+
+    if (map != MAP_FAILED) {
+        const char* data = static_cast<const char*>(map);
+        size_t size = static_cast<size_t>(st.st_size);
+        madvise(map, size, MADV_SEQUENTIAL);
+
+        // Walk the file in windows and release each one once tokenized,
+        // so resident memory stays flat on huge inputs
+        bool more = true;
+        for (size_t offset = 0; more && offset < size; offset += MAP_WINDOW) {
+            size_t len = std::min(MAP_WINDOW, size - offset);
+            more = tokenizer.feed(data + offset, len);
+            madvise(const_cast<char*>(data) + offset, len, MADV_DONTNEED);
+        }
+        if (more) {
+            tokenizer.finish();
+        }
+        munmap(map, size);
+    } else {
+        char buf[READ_CHUNK];
+        while (true) {
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) {
+                std::cerr << "Error: Cannot read " << path << ": " << std::strerror(errno) << "\n";
+                ok = false;
+                break;
+            }
+            if (n == 0) {
+                tokenizer.finish();
+                break;
+            }
+            if (!tokenizer.feed(buf, static_cast<size_t>(n))) break;
+        }
+    }
+
+    if (fd != STDIN_FILENO) {
+        ::close(fd);
+    }
+    return ok;
+}
+
+bool run_pipeline(const std::string& path,
+                  const std::function<bool(const InputAddress&)>& scan,
+                  InputStats& stats,
+                  size_t queue_capacity) {
+    BoundedQueue<Token> tokens(queue_capacity);
+    BoundedQueue<InputAddress> addresses(queue_capacity);
+
+    // Stage 1: parse
+    bool read_ok = true;
+    std::thread reader([&]() {
+        read_ok = for_each_token(path, [&](const std::string& text, size_t line) {
+            stats.tokens++;
+            return tokens.push({text, line});
+        });
+        tokens.close();
+    });
+
+    // Stage 2: validate and checksum
+    std::thread validator([&]() {
+        uint64_t index = 0;
+        while (auto token = tokens.pop()) {
+            if (!Address::is_valid(token->text)) {
+                stats.invalid++;
+                std::cerr << "Warning: Line " << token->line << ": invalid address " << token->text << "\n";
+                continue;
+            }
+            if (has_mixed_case(token->text) && !Address::verify_checksum(token->text)) {
+                stats.bad_checksum++;
+                std::cerr << "Warning: Line " << token->line << ": bad checksum " << token->text << "\n";
+                continue;
+            }
+            if (!addresses.push({Address::to_checksum(token->text), token->line, index++})) {
+                break;
+            }
+        }
+        addresses.close();
+        tokens.close();
+    });
+
+    // Stage 3: scan, on the calling thread
+    while (auto address = addresses.pop()) {
+        stats.scanned++;
+        if (!scan(*address)) {
+            break;
+        }
+    }
+
+    // Unblock the earlier stages if the scan stage stopped early
+    addresses.close();
+    tokens.close();
+    reader.join();
+    validator.join();
+    return read_ok;
+}
+
+} // namespace AddressInput
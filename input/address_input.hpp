@@ -0,0 +1,67 @@
+#ifndef ADDRESS_INPUT_HPP
+#define ADDRESS_INPUT_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/**
+ * Address read from an input file
+ */
+struct InputAddress {
+    std::string address;    // EIP-55 checksummed
+    size_t line;            // 1-based line in the input
+    uint64_t index;         // 0-based position among valid addresses
+};
+
+/**
+ * Totals of a pipeline run
+ */
+struct InputStats {
+    uint64_t tokens = 0;        // tokens read from the input
+    uint64_t invalid = 0;       // not an address
+    uint64_t bad_checksum = 0;  // mixed case with a wrong EIP-55 checksum
+    uint64_t scanned = 0;       // handed to the scan stage
+};
+
+/**
+ * Address input from files and stdin
+ *
+ * Tokens are separated by whitespace, commas or semicolons; `#` starts a
+ * comment that runs to the end of the line. Regular files are memory
+ * mapped, pipes and stdin ("-") are read in fixed-size chunks, so the
+ * input size does not affect memory use.
+ */
+namespace AddressInput {
+
+constexpr size_t DEFAULT_QUEUE_CAPACITY = 1024;
+
+/**
+ * Call a function for every token of an input
+ * @param path File path, or "-" for stdin
+ * @param on_token Receives the token and its line; return false to stop
+ * @return false if the input could not be opened or read
+ */
+bool for_each_token(const std::string& path,
+                    const std::function<bool(const std::string&, size_t)>& on_token);
+
+/**
+ * Run the input pipeline: parse -> validate/checksum -> scan
+ * The parse and validate stages run on their own threads and hand items
+ * on through bounded queues; the scan stage runs on the calling thread.
+ * When scanning falls behind, the queues fill and the reader waits.
+ * Invalid tokens are reported on stderr and skipped.
+ * @param path File path, or "-" for stdin
+ * @param scan Scan stage; return false to stop the pipeline
+ * @param stats Filled with the totals of the run
+ * @param queue_capacity Capacity of each queue between stages
+ * @return false if the input could not be read
+ */
+bool run_pipeline(const std::string& path,
+                  const std::function<bool(const InputAddress&)>& scan,
+                  InputStats& stats,
+                  size_t queue_capacity = DEFAULT_QUEUE_CAPACITY);
+
+} // namespace AddressInput
+
+#endif // ADDRESS_INPUT_HPP
@@ -0,0 +1,238 @@
+#include "aimd_limiter.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <memory>
+#include <unordered_map>
+
+// AimdLimiter
+
+AimdLimiter::AimdLimiter(double initial, double min, double max)
+    : limit_(initial), min_(min), max_(max) {
+    limit_ = std::clamp(limit_, min_, max_);
+    counters_.peak = limit_;
+}
+
+void AimdLimiter::acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    slot_freed_.wait(lock, [&] {
+        return in_flight_ < std::max<size_t>(1, static_cast<size_t>(limit_));
+    });
+    in_flight_++;
+}
+
+bool AimdLimiter::release(RequestOutcome outcome, double inflation) {
+    auto now = std::chrono::steady_clock::now();
+    bool was_cut = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_flight_--;
+        counters_.requests++;
+
+        switch (outcome) {
+        case RequestOutcome::Ok:
+            if (inflation > LATENCY_TOLERANCE) {
+                if ((was_cut = cut(LATENCY_BACKOFF, now))) counters_.cuts_latency++;
+            } else {
+                limit_ = std::min(max_, limit_ + (slow_start_ ? INCREASE : INCREASE / limit_));
+                counters_.peak = std::max(counters_.peak, limit_);
+            }
+            break;
+        case RequestOutcome::RateLimited:
+            if ((was_cut = cut(BACKOFF, now))) counters_.cuts_rate_limited++;
+            break;
+        case RequestOutcome::Timeout:
+            if ((was_cut = cut(BACKOFF, now))) counters_.cuts_timeout++;
+            break;
+        case RequestOutcome::Failed:
+            break;
+        }
+    }
+    slot_freed_.notify_all();
+    return was_cut;
+}
+
+bool AimdLimiter::cut(double factor, std::chrono::steady_clock::time_point now) {
+    if (now - last_cut_ < CUT_INTERVAL) {
+        return false;
+    }
+    last_cut_ = now;
+    slow_start_ = false;
+    limit_ = std::max(min_, limit_ * factor);
+    return true;
+}
+
+double AimdLimiter::limit() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return limit_;
+}
+
+size_t AimdLimiter::in_flight() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return in_flight_;
+}
+
+AimdLimiter::Counters AimdLimiter::counters() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return counters_;
+}
+
+// ConcurrencyControl
+
+namespace ConcurrencyControl {
+
+struct HostState {
+    explicit HostState(double max) : limiter(HOST_INITIAL, 1.0, max) {}
+
+    AimdLimiter limiter;
+    std::mutex mutex;
+    double baseline_ms = -1.0;   // fastest successful answer
+    double average_ms = -1.0;    // moving average of successful answers
+};
+
+namespace {
+
+constexpr size_t MAX_SAMPLES = 10000;
+constexpr double LATENCY_ALPHA = 0.1;   // weight of a new sample in the moving average
+constexpr double MIN_BASELINE_MS = 25;  // below this, process start-up noise dominates
+
+std::atomic<bool> active{false};
+std::unique_ptr<AimdLimiter> global;
+double max_limit = 0.0;
+std::chrono::steady_clock::time_point started;
+
+std::mutex hosts_mutex;
+std::unordered_map<std::string, std::unique_ptr<HostState>> hosts;
+
+std::mutex samples_mutex;
+std::vector<Sample> samples;
+
+void sample_global() {
+    double limit = global->limit();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    std::lock_guard<std::mutex> lock(samples_mutex);
+    if (!samples.empty() && std::floor(samples.back().limit) == std::floor(limit)) {
+        return;
+    }
+    if (samples.size() < MAX_SAMPLES) {
+        samples.push_back({seconds, limit});
+    }
+}
+
+} // anonymous namespace
+
+void enable(size_t max_in_flight, double initial) {
+    max_limit = static_cast<double>(std::max<size_t>(max_in_flight, 1));
+    global = std::make_unique<AimdLimiter>(initial, 2.0, max_limit);
+    started = std::chrono::steady_clock::now();
+    samples.push_back({0.0, global->limit()});
+    active = true;
+}
+
+bool enabled() {
+    return active;
+}
+
+Permit::Permit(const std::string& host) {
+    if (!active) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(hosts_mutex);
+        auto& state = hosts[host];
+        if (!state) {
+            state = std::make_unique<HostState>(max_limit);
+        }
+        host_ = state.get();
+    }
+
+    // Host first, so a request waiting on a busy host holds no global slot
+    host_->limiter.acquire();
+    global->acquire();
+}
+
+Permit::~Permit() {
+    if (host_ && !finished_) {
+        finish(RequestOutcome::Failed, -1.0);
+    }
+}
+
+void Permit::finish(RequestOutcome outcome, double latency_ms) {
+    if (!host_ || finished_) {
+        return;
+    }
+    finished_ = true;
+
+    double inflation = 0.0;
+    if (outcome == RequestOutcome::Ok && latency_ms >= 0.0) {
+        std::lock_guard<std::mutex> lock(host_->mutex);
+        if (host_->baseline_ms < 0.0 || latency_ms < host_->baseline_ms) {
+            host_->baseline_ms = latency_ms;
+        }
+        host_->average_ms = host_->average_ms < 0.0
+            ? latency_ms
+            : host_->average_ms + LATENCY_ALPHA * (latency_ms - host_->average_ms);
+        // Smoothed, so a single slow answer is not taken for congestion
+        inflation = host_->average_ms / std::max(host_->baseline_ms, MIN_BASELINE_MS);
+    }
+
+    host_->limiter.release(outcome, inflation);
+
+    // Host-specific trouble does not shrink the global limit
+    bool load_signal = outcome == RequestOutcome::Ok;
+    global->release(load_signal ? outcome : RequestOutcome::Failed, inflation);
+    sample_global();
+}
+
+std::vector<Sample> trajectory() {
+    std::lock_guard<std::mutex> lock(samples_mutex);
+    return samples;
+}
+
+void print_summary(std::ostream& out) {
+    if (!active) {
+        return;
+    }
+
+    AimdLimiter::Counters totals = global->counters();
+    size_t host_count = 0;
+    size_t hosts_cut = 0;
+    {
+        std::lock_guard<std::mutex> lock(hosts_mutex);
+        host_count = hosts.size();
+        for (const auto& [name, state] : hosts) {
+            auto c = state->limiter.counters();
+            totals.cuts_rate_limited += c.cuts_rate_limited;
+            totals.cuts_timeout += c.cuts_timeout;
+            totals.cuts_latency += c.cuts_latency;
+            if (c.cuts_rate_limited + c.cuts_timeout + c.cuts_latency > 0) {
+                hosts_cut++;
+            }
+        }
+    }
+
+    auto points = trajectory();
+    out << "Concurrency (auto): " << std::fixed << std::setprecision(0)
+        << (points.empty() ? 0.0 : points.front().limit) << " -> " << global->limit()
+        << " requests in flight (peak " << totals.peak << ", max " << max_limit << ") over "
+        << host_count << " host(s)\n"
+        << "Cuts: " << totals.cuts_rate_limited << " rate limited, " << totals.cuts_timeout << " timeout, "
+        << totals.cuts_latency << " latency; " << hosts_cut << " host(s) backed off\n";
+
+    // At most 16 points, evenly spread over the samples
+    if (points.size() > 1) {
+        out << "Trajectory:";
+        size_t shown = std::min<size_t>(points.size(), 16);
+        for (size_t i = 0; i < shown; i++) {
+            const Sample& s = points[i * (points.size() - 1) / (shown - 1)];
+            out << " " << std::setprecision(1) << s.seconds << "s:" << std::setprecision(0) << s.limit;
+        }
+        out << "\n";
+    }
+    out << std::defaultfloat << std::setprecision(6);
+}
+
+} // namespace ConcurrencyControl
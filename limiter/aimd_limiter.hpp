@@ -0,0 +1,149 @@
+#ifndef AIMD_LIMITER_HPP
+#define AIMD_LIMITER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * How a request ended, as seen by the concurrency controller
+ */
+enum class RequestOutcome {
+    Ok,           // answered with HTTP 200
+    RateLimited,  // HTTP 429 or 503
+    Timeout,      // no answer before the transport timeout
+    Failed        // anything else (refused, 4xx, 5xx, bad body); not a load signal
+};
+
+/**
+ * Additive-increase, multiplicative-decrease limit on requests in flight
+ *
+ * Until the first cut the limit grows by one per successful request
+ * (slow start, doubling every round); after that each success adds
+ * 1 / limit, so it rises by about one per round of `limit` requests. A rate limit or timeout halves
+ * it, and latency above LATENCY_TOLERANCE times the baseline cuts it by
+ * 10%. At most one cut is applied per CUT_INTERVAL, so a burst of
+ * failures from requests that were already in flight counts once.
+ */
+class AimdLimiter {
+public:
+    static constexpr double INCREASE = 1.0;           // per round of `limit` successes
+    static constexpr double BACKOFF = 0.5;            // on rate limits and timeouts
+    static constexpr double LATENCY_BACKOFF = 0.9;    // on inflated latency
+    static constexpr double LATENCY_TOLERANCE = 3.0;  // latency / baseline counted as congestion
+    static constexpr std::chrono::milliseconds CUT_INTERVAL{500};
+
+    /**
+     * Totals since construction
+     */
+    struct Counters {
+        uint64_t requests = 0;
+        uint64_t cuts_rate_limited = 0;
+        uint64_t cuts_timeout = 0;
+        uint64_t cuts_latency = 0;
+        double peak = 0.0;
+    };
+
+    AimdLimiter(double initial, double min, double max);
+
+    /**
+     * Wait until a request may start
+     */
+    void acquire();
+
+    /**
+     * Finish a request and adapt the limit
+     * @param outcome How the request ended
+     * @param inflation Smoothed latency divided by the endpoint's baseline (0 if unknown)
+     * @return true if the limit was cut
+     */
+    bool release(RequestOutcome outcome, double inflation);
+
+    double limit() const;
+    size_t in_flight() const;
+    Counters counters() const;
+
+private:
+    bool cut(double factor, std::chrono::steady_clock::time_point now);
+
+    mutable std::mutex mutex_;
+    std::condition_variable slot_freed_;
+    double limit_;
+    double min_;
+    double max_;
+    size_t in_flight_ = 0;
+    bool slow_start_ = true;
+    std::chrono::steady_clock::time_point last_cut_{};
+    Counters counters_;
+};
+
+/**
+ * Process-wide adaptive concurrency for RPC requests (`-t auto`)
+ *
+ * Each endpoint host has its own AimdLimiter, and one global limiter
+ * caps the total. Rate limits and timeouts cut only the host's limit;
+ * the global limit reacts to latency inflation measured against each
+ * host's fastest answer, which is what local saturation looks like.
+ * While disabled, permits are free.
+ */
+namespace ConcurrencyControl {
+
+constexpr double DEFAULT_INITIAL = 8;       // global limit at start
+constexpr double HOST_INITIAL = 4;          // per-host limit at start
+
+/**
+ * Global limit over time
+ */
+struct Sample {
+    double seconds;     // since enable()
+    double limit;
+};
+
+/**
+ * Turn the controller on
+ * @param max_in_flight Upper bound of the global limit
+ * @param initial Global limit at start
+ */
+void enable(size_t max_in_flight, double initial = DEFAULT_INITIAL);
+
+bool enabled();
+
+struct HostState;
+
+/**
+ * Right to run one request against a host
+ * Waits for the host's and the global limiter. finish() reports the
+ * outcome; a permit dropped without it counts as Failed.
+ */
+class Permit {
+public:
+    explicit Permit(const std::string& host);
+    ~Permit();
+
+    Permit(const Permit&) = delete;
+    Permit& operator=(const Permit&) = delete;
+
+    void finish(RequestOutcome outcome, double latency_ms);
+
+private:
+    HostState* host_ = nullptr;  // null while disabled
+    bool finished_ = false;
+};
+
+/**
+ * Samples of the global limit, taken when its integer part changes
+ */
+std::vector<Sample> trajectory();
+
+/**
+ * Print the limits reached, the cuts by cause and the trajectory
+ */
+void print_summary(std::ostream& out);
+
+} // namespace ConcurrencyControl
+
+#endif // AIMD_LIMITER_HPP
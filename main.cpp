@@ -1,13 +1,28 @@
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
+#include <mutex>
 #include <cstring>
 #include <sstream>
 #include <vector>
+#include <ctime>
+#include <unistd.h>
 
 #include "address/address.hpp"
 #include "chain/chain.hpp"
 #include "rpc/rpc.hpp"
 #include "multi_checker/multi_checker.hpp"
+#include "activity/activity.hpp"
+#include "daemon/daemon.hpp"
+#include "server/http_server.hpp"
+#include "output/result_sink.hpp"
+#include "input/address_input.hpp"
+#include "scheduler/scan_scheduler.hpp"
+#include "priority/chain_priority.hpp"
+#include "limiter/aimd_limiter.hpp"
+#include "metrics/metrics.hpp"
+#include "trace/trace.hpp"
+#include "cassette/cassette.hpp"
 
 void print_usage(const char *prog) {
     std::cout << "Usage: " << prog << " <address[,address,...]> [options]\n\n"
@@ -15,13 +30,49 @@ void print_usage(const char *prog) {
               << "  -c, --checksum       Verify EIP-55 checksum\n"
               << "  -f, --fix            Output checksummed address\n"
               << "  -i, --info <chain>   Show address info (balance, tx, tokens)\n"
+              << "  -A, --activity       With --info, find first/last active block (archive RPC)\n"
+              << "  -p, --proof          Query via eth_getProof (adds contract detection)\n"
               << "  -a, --scan-all       Scan address across all chains (including testnets)\n"
-              << "  -t, --threads <N>    Number of concurrent threads (default: 1, max: 100)\n"
+              << "  --cache              Reuse results from data/results.cache (shared by processes)\n"
+              << "  --cache-ttl <blocks> Cache freshness in blocks of each chain (default: 25)\n"
+              << "  --offline            Answer from the result cache only (implies --cache)\n"
+              << "  --skip-empty         Skip chains recorded empty in data/empty.filter\n"
+              << "  --reverify <rate>    Fraction of known-empty chains to query anyway (default: 0)\n"
+              << "  --empty-fpr <p>      False-positive rate of a new empty filter (default: 0.01)\n"
+              << "  --empty-expiry <d>   Days until empty entries expire (default: 7)\n"
+              << "  --probe              Probe endpoints with eth_chainId and drop dead ones first\n"
+              << "  --probe-timeout <s>  Probe timeout per endpoint in seconds (default: 2)\n"
+              << "  --input <file|->     Scan addresses read from a file or stdin (implies -a)\n"
+              << "  --weights <list>     Scan priority weights, e.g. 1=10,8453=5 (default: 1)\n"
+              << "  --top-k <N>          Stop once the N highest-priority chains are scanned\n"
+              << "  --batch <N>          Addresses per RPC request when scanning several (default: 8)\n"
+              << "  -o, --output <fmt>   Scan output: table, ndjson or csv (default: table)\n"
+              << "  --ordered            Stream ndjson/csv rows in chain ID order\n"
+              << "  --socket <path>      Send scans to a running daemon instead of scanning locally\n"
+              << "  -t, --threads <N>    Number of concurrent threads (default: 1, max: 100),\n"
+              << "                       or auto to adapt requests in flight to the endpoints\n"
+              << "  --workers <N>        Size of the worker pool shared by all scans (default: -t)\n"
+              << "  --metrics <file>     Write Prometheus metrics at scan end and on SIGUSR1\n"
+              << "  --trace <file>       Write a Chrome trace-event timeline of the scan (Perfetto)\n"
+              << "  --record <dir>       Record every RPC request and response to <dir>/rpc.cassette\n"
+              << "  --replay <dir>       Answer RPC requests from a recording instead of the network\n"
+              << "  --replay-speed <x>   Replay latencies x times faster, 0 for none (default: 1)\n"
               << "  -l, --list-chains    List supported chains\n"
               << "  -u, --update-rpcs    Update RPCs from chainlist.org\n"
               << "  -h, --help           Show this help\n\n"
+              << "Daemon mode:\n"
+              << "  " << prog << " --daemon [--socket <path>] [--probe] [-t <N>] [--workers <N>] [--metrics <file>]\n"
+              << "  Serves scans on a Unix socket (default: data/checker.sock) with the\n"
+              << "  chain registry, caches and endpoint health kept in memory\n"
+              << "  " << prog << " --dump-metrics [--socket <path>]\n"
+              << "  Prints the daemon's metrics in the Prometheus text format\n\n"
+              << "HTTP API:\n"
+              << "  " << prog << " --serve [--bind <addr>] [--port <N>] [-t <N>] [--workers <N>] [--metrics <file>]\n"
+              << "  GET /scan, /info, /checksum and /metrics on 127.0.0.1:8080; scans stream NDJSON\n\n"
               << "Multiple addresses can be separated by commas:\n"
-              << "  " << prog << " \"0xAddr1, 0xAddr2, 0xAddr3\" -a -t 10\n";
+              << "  " << prog << " \"0xAddr1, 0xAddr2, 0xAddr3\" -a -t 10\n"
+              << "or read from a file (one or more per line, - for stdin):\n"
+              << "  " << prog << " --input addresses.txt -t 10 -o ndjson\n";
 }
 
 // helper function to split and trim comma-separated addresses
@@ -40,6 +91,19 @@ std::vector<std::string> split_addresses(const std::string& input) {
     return addresses;
 }
 
+// format unix timestamp as UTC date
+std::string format_timestamp(uint64_t ts) {
+    if (ts == 0) return "unknown time";
+    
+    std::time_t t = static_cast<std::time_t>(ts);
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+    
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S UTC", &tm);
+    return buf;
+}
+
 void list_chains() {
     const auto& chains = ChainRegistry::get_all();
     
@@ -56,17 +120,73 @@ void list_chains() {
 }
 
 int main(int argc, char *argv[]) {
-    // Check for update flag early
+    // Check for update and cassette flags early
     bool force_update = false;
+    std::string record_dir;
+    std::string replay_dir;
+    double replay_speed = 1.0;
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-u") == 0 || strcmp(argv[i], "--update-rpcs") == 0) {
             force_update = true;
-            break;
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_dir = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_dir = argv[++i];
+        } else if (strcmp(argv[i], "--replay-speed") == 0 && i + 1 < argc) {
+            try {
+                replay_speed = std::stod(argv[++i]);
+                if (!(replay_speed >= 0.0)) throw std::out_of_range("speed");
+            } catch (...) {
+                std::cerr << "Error: Invalid replay speed\n";
+                return 1;
+            }
+        }
+    }
+    if (!record_dir.empty() && !replay_dir.empty()) {
+        std::cerr << "Error: Use either --record or --replay\n";
+        return 1;
+    }
+
+    // Clients of the daemon scan through it and do not need the registry
+    bool daemon_client = argc > 1 && strcmp(argv[1], "--dump-metrics") == 0;
+    if (argc > 1 && (argv[1][0] != '-' || strcmp(argv[1], "--input") == 0)) {
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--socket") == 0) {
+                daemon_client = true;
+                break;
+            }
         }
     }
 
-    // Initialize chains (fetch RPCs)
-    ChainRegistry::init(force_update);
+    // Chains are loaded by the modes that use them, so offline commands (checksums, --help)
+    // never parse the registry or fetch it; a replay uses the registry it was recorded with
+    bool registry_ready = false;
+    auto init_registry = [&]() {
+        if (registry_ready) return;
+        registry_ready = true;
+        std::string recorded_registry = replay_dir.empty() ? "" : replay_dir + "/" + Cassette::REGISTRY_NAME;
+        if (recorded_registry.empty() || !ChainRegistry::load(recorded_registry)) {
+            ChainRegistry::init(force_update);
+        }
+        Cassette::save_registry("data/rpcs.json");
+    };
+    
+    // Capture or play back the RPC traffic of every mode below
+    if (!record_dir.empty() && !Cassette::record_to(record_dir)) {
+        std::cerr << "Error: Cannot record to " << record_dir << "\n";
+        return 1;
+    }
+    if (!replay_dir.empty() && !Cassette::replay_from(replay_dir, replay_speed)) {
+        std::cerr << "Error: No readable cassette in " << replay_dir << "\n";
+        return 1;
+    }
+    struct CloseCassette {
+        ~CloseCassette() { Cassette::close(std::cerr); }
+    } close_cassette;
+    
+    if (force_update && !daemon_client) {
+        init_registry();
+    }
 
     if (argc < 2) {
         print_usage(argv[0]);
@@ -81,23 +201,155 @@ int main(int argc, char *argv[]) {
     }
     
     if (strcmp(arg1, "-l") == 0 || strcmp(arg1, "--list-chains") == 0) {
+        init_registry();
         list_chains();
         return 0;
     }
 
     if (strcmp(arg1, "-u") == 0 || strcmp(arg1, "--update-rpcs") == 0) {
-        // RPCs already updated by init() at start of main
+        // RPCs already updated by init_registry() at start of main
+        return 0;
+    }
+
+    if (strcmp(arg1, "--dump-metrics") == 0) {
+        DaemonOptions defaults;
+        std::string socket_path = defaults.socket_path;
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+                socket_path = argv[++i];
+            }
+        }
+        std::string text;
+        std::string error;
+        if (!ScanDaemon::request_metrics(socket_path, text, error)) {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
+        }
+        std::cout << text;
         return 0;
     }
+
+    if (strcmp(arg1, "--daemon") == 0) {
+        DaemonOptions daemon_options;
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+                daemon_options.socket_path = argv[++i];
+            } else if (strcmp(argv[i], "--probe") == 0) {
+                daemon_options.probe_endpoints = true;
+            } else if (strcmp(argv[i], "--probe-timeout") == 0 && i + 1 < argc) {
+                try {
+                    daemon_options.probe_timeout = std::stod(argv[++i]);
+                    if (!(daemon_options.probe_timeout > 0.0)) throw std::out_of_range("timeout");
+                } catch (...) {
+                    std::cerr << "Error: Invalid probe timeout\n";
+                    return 1;
+                }
+            } else if ((strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--threads") == 0) && i + 1 < argc) {
+                try {
+                    daemon_options.default_threads = std::stoull(argv[++i]);
+                    if (daemon_options.default_threads < 1) daemon_options.default_threads = 1;
+                    if (daemon_options.default_threads > 100) daemon_options.default_threads = 100;
+                } catch (...) {
+                    std::cerr << "Error: Invalid thread count\n";
+                    return 1;
+                }
+            } else if (strcmp(argv[i], "--weights") == 0 && i + 1 < argc) {
+                if (!ChainPriority::parse_weights(argv[++i])) {
+                    std::cerr << "Error: Invalid weights (expected chain_id=weight,...)\n";
+                    return 1;
+                }
+            } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+                try {
+                    daemon_options.workers = std::stoull(argv[++i]);
+                    if (daemon_options.workers < 1) daemon_options.workers = 1;
+                    if (daemon_options.workers > 500) daemon_options.workers = 500;
+                } catch (...) {
+                    std::cerr << "Error: Invalid worker count\n";
+                    return 1;
+                }
+            } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+                daemon_options.metrics_path = argv[++i];
+            }
+        }
+        // Probes go straight to the network, which a replay stands in for
+        daemon_options.probe_endpoints = daemon_options.probe_endpoints && !Cassette::replaying();
+        init_registry();
+        return ScanDaemon::run(daemon_options);
+    }
+
+    if (strcmp(arg1, "--serve") == 0) {
+        HttpServerOptions server_options;
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--bind") == 0 && i + 1 < argc) {
+                server_options.bind_address = argv[++i];
+            } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+                try {
+                    unsigned long port = std::stoul(argv[++i]);
+                    if (port < 1 || port > 65535) throw std::out_of_range("port");
+                    server_options.port = static_cast<uint16_t>(port);
+                } catch (...) {
+                    std::cerr << "Error: Invalid port\n";
+                    return 1;
+                }
+            } else if ((strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--threads") == 0) && i + 1 < argc) {
+                try {
+                    server_options.max_threads = std::stoull(argv[++i]);
+                    if (server_options.max_threads < 1) server_options.max_threads = 1;
+                    if (server_options.max_threads > 100) server_options.max_threads = 100;
+                    server_options.default_threads = std::min(server_options.default_threads, server_options.max_threads);
+                } catch (...) {
+                    std::cerr << "Error: Invalid thread count\n";
+                    return 1;
+                }
+            } else if (strcmp(argv[i], "--weights") == 0 && i + 1 < argc) {
+                if (!ChainPriority::parse_weights(argv[++i])) {
+                    std::cerr << "Error: Invalid weights (expected chain_id=weight,...)\n";
+                    return 1;
+                }
+            } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+                try {
+                    server_options.workers = std::stoull(argv[++i]);
+                    if (server_options.workers < 1) server_options.workers = 1;
+                    if (server_options.workers > 500) server_options.workers = 500;
+                } catch (...) {
+                    std::cerr << "Error: Invalid worker count\n";
+                    return 1;
+                }
+            } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+                server_options.metrics_path = argv[++i];
+            }
+        }
+        init_registry();
+        return HttpServer::run(server_options);
+    }
     
-    std::string_view address = arg1;
+    // With --input, addresses come from a file and options start at argv[1]
+    bool input_first = strcmp(arg1, "--input") == 0;
+    std::string_view address = input_first ? "" : arg1;
+    std::string input_path;
     bool verify_checksum = false;
     bool fix_checksum = false;
     uint64_t info_chain_id = 0;
     bool scan_all = false;
-    size_t num_threads = 1;  // default: safe single thread
+    bool find_activity = false;
+    bool use_cache = false;
+    double empty_fpr = EmptyFilter::DEFAULT_FPR;
+    uint64_t empty_expiry = EmptyFilter::DEFAULT_EXPIRY;
+    ScanOptions scan_options;
+    scan_options.include_testnets = true;
+    QueryOptions& query = scan_options.query;
+    size_t& num_threads = scan_options.num_threads;  // default: safe single thread
+    bool threads_set = false;
+    bool auto_threads = false;  // -t auto: adaptive request concurrency
+    size_t num_workers = 0;     // 0: as many as -t
+    std::string output_format = "table";
+    bool ordered_output = false;
+    size_t batch_addresses = ScanScheduler::DEFAULT_BATCH_ADDRESSES;
+    std::string socket_path;
+    std::string metrics_path;
+    std::string trace_path;
     
-    for (int i = 2; i < argc; i++) {
+    for (int i = input_first ? 1 : 2; i < argc; i++) {
         if (strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--checksum") == 0) {
             verify_checksum = true;
         } else if (strcmp(argv[i], "-f") == 0 || strcmp(argv[i], "--fix") == 0) {
@@ -111,26 +363,354 @@ int main(int argc, char *argv[]) {
                     return 1;
                 }
             }
+        } else if (strcmp(argv[i], "-A") == 0 || strcmp(argv[i], "--activity") == 0) {
+            find_activity = true;
+        } else if (strcmp(argv[i], "-p") == 0 || strcmp(argv[i], "--proof") == 0) {
+            query.plan = QueryPlan::Proof;
+        } else if (strcmp(argv[i], "--cache") == 0) {
+            use_cache = true;
+        } else if (strcmp(argv[i], "--offline") == 0) {
+            use_cache = true;
+            scan_options.offline = true;
+        } else if (strcmp(argv[i], "--cache-ttl") == 0) {
+            if (i + 1 < argc) {
+                try {
+                    scan_options.cache_ttl_blocks = std::stoull(argv[++i]);
+                } catch (...) {
+                    std::cerr << "Error: Invalid cache TTL\n";
+                    return 1;
+                }
+            }
+        } else if (strcmp(argv[i], "--skip-empty") == 0) {
+            scan_options.skip_empty = true;
+        } else if (strcmp(argv[i], "--reverify") == 0 || strcmp(argv[i], "--empty-fpr") == 0) {
+            bool reverify = strcmp(argv[i], "--reverify") == 0;
+            if (i + 1 < argc) {
+                try {
+                    double value = std::stod(argv[++i]);
+                    if (reverify && value >= 0.0 && value <= 1.0) {
+                        scan_options.reverify_rate = value;
+                    } else if (!reverify && value > 0.0 && value < 1.0) {
+                        empty_fpr = value;
+                    } else {
+                        throw std::out_of_range("rate");
+                    }
+                } catch (...) {
+                    std::cerr << "Error: Invalid " << (reverify ? "reverify rate" : "false-positive rate") << "\n";
+                    return 1;
+                }
+            }
+        } else if (strcmp(argv[i], "--empty-expiry") == 0) {
+            if (i + 1 < argc) {
+                try {
+                    empty_expiry = std::stoull(argv[++i]) * 86400;
+                } catch (...) {
+                    std::cerr << "Error: Invalid expiry\n";
+                    return 1;
+                }
+            }
+        } else if (strcmp(argv[i], "--probe") == 0) {
+            scan_options.probe_endpoints = true;
+        } else if (strcmp(argv[i], "--probe-timeout") == 0) {
+            if (i + 1 < argc) {
+                try {
+                    scan_options.probe_timeout = std::stod(argv[++i]);
+                    if (!(scan_options.probe_timeout > 0.0)) throw std::out_of_range("timeout");
+                } catch (...) {
+                    std::cerr << "Error: Invalid probe timeout\n";
+                    return 1;
+                }
+            }
+        } else if (strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) {
+            if (i + 1 < argc) {
+                output_format = argv[++i];
+                if (output_format != "table" && output_format != "ndjson" && output_format != "csv") {
+                    std::cerr << "Error: Unknown output format " << output_format << "\n";
+                    return 1;
+                }
+            }
+        } else if (strcmp(argv[i], "--input") == 0) {
+            if (i + 1 < argc) {
+                input_path = argv[++i];
+                scan_all = true;
+            }
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            if (i + 1 < argc) {
+                try {
+                    batch_addresses = std::stoull(argv[++i]);
+                    if (batch_addresses < 1) batch_addresses = 1;
+                    if (batch_addresses > 100) batch_addresses = 100;
+                } catch (...) {
+                    std::cerr << "Error: Invalid batch size\n";
+                    return 1;
+                }
+            }
+        } else if (strcmp(argv[i], "--ordered") == 0) {
+            ordered_output = true;
+        } else if (strcmp(argv[i], "--socket") == 0) {
+            if (i + 1 < argc) {
+                socket_path = argv[++i];
+            }
         } else if (strcmp(argv[i], "-a") == 0 || strcmp(argv[i], "--scan-all") == 0) {
             scan_all = true;
         } else if (strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--threads") == 0) {
-            if (i + 1 < argc) {
+            if (i + 1 < argc && strcmp(argv[i + 1], "auto") == 0) {
+                // Workers for the worst case; the controller decides how many requests run
+                i++;
+                num_threads = 100;
+                auto_threads = true;
+            } else if (i + 1 < argc) {
                 try {
                     num_threads = std::stoull(argv[++i]);
                     if (num_threads < 1) num_threads = 1;
                     if (num_threads > 100) num_threads = 100;
+                    threads_set = true;
                 } catch (...) {
                     std::cerr << "Error: Invalid thread count\n";
                     return 1;
                 }
             }
+        } else if (strcmp(argv[i], "--weights") == 0) {
+            if (i + 1 < argc && !ChainPriority::parse_weights(argv[++i])) {
+                std::cerr << "Error: Invalid weights (expected chain_id=weight,...)\n";
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--top-k") == 0) {
+            if (i + 1 < argc) {
+                try {
+                    scan_options.top_k = std::stoull(argv[++i]);
+                } catch (...) {
+                    std::cerr << "Error: Invalid top-k count\n";
+                    return 1;
+                }
+            }
+        } else if (strcmp(argv[i], "--workers") == 0) {
+            if (i + 1 < argc) {
+                try {
+                    num_workers = std::stoull(argv[++i]);
+                    if (num_workers < 1) num_workers = 1;
+                    if (num_workers > 500) num_workers = 500;
+                } catch (...) {
+                    std::cerr << "Error: Invalid worker count\n";
+                    return 1;
+                }
+            }
+        } else if (strcmp(argv[i], "--metrics") == 0) {
+            if (i + 1 < argc) {
+                metrics_path = argv[++i];
+            }
+        } else if (strcmp(argv[i], "--trace") == 0) {
+            if (i + 1 < argc) {
+                trace_path = argv[++i];
+            }
         }
     }
     
+    // Probes go straight to the network, which a replay stands in for
+    if (Cassette::replaying()) {
+        scan_options.probe_endpoints = false;
+    }
+    
+    if (!input_path.empty() && !address.empty()) {
+        std::cerr << "Error: Give addresses either on the command line or with --input\n";
+        return 1;
+    }
+    
+    // The daemon owns the caches when scans go through it
+    bool skip_empty_requested = scan_options.skip_empty;
+    if (daemon_client) {
+        use_cache = false;
+        scan_options.skip_empty = false;
+    }
+    
+    if (use_cache && !ResultCache::open()) {
+        std::cerr << "Error: Result cache unavailable\n";
+        return 1;
+    }
+    
+    if (scan_options.skip_empty &&
+        !EmptyFilter::open(EmptyFilter::DEFAULT_PATH, EmptyFilter::DEFAULT_ENTRIES, empty_fpr, empty_expiry)) {
+        std::cerr << "Error: Empty filter unavailable\n";
+        return 1;
+    }
+    
     // Multi-chain scan (includes testnets by default) - handles multi-address validation internally
     if (scan_all) {
+        // One pool serves every address of the run
+        if (!daemon_client) {
+            init_registry();
+            
+            // Before the pool starts, so its threads are named in the timeline
+            if (!trace_path.empty()) {
+                Trace::enable();
+                Trace::set_thread_name("main");
+            }
+            MultiChainChecker::init_pool(num_workers > 0 ? num_workers : num_threads);
+            ChainPriority::load();
+            if (auto_threads) {
+                ConcurrencyControl::enable(num_threads);
+            }
+            if (!metrics_path.empty()) {
+                Metrics::enable();
+                Metrics::dump_on_signal(metrics_path);
+            }
+        }
+        
+        // Keep what this run learned about chain activity, its metrics and trace, on every exit path
+        struct FinishRun {
+            const std::string& metrics_path;
+            const std::string& trace_path;
+            ~FinishRun() {
+                ChainPriority::save();
+                if (Metrics::enabled() && !Metrics::write_file(metrics_path)) {
+                    std::cerr << "Warning: Cannot write metrics to " << metrics_path << "\n";
+                }
+                uint64_t dropped = 0;
+                if (Trace::enabled() && !Trace::write_file(trace_path, &dropped)) {
+                    std::cerr << "Warning: Cannot write trace to " << trace_path << "\n";
+                } else if (dropped > 0) {
+                    std::cerr << "Warning: Trace lost its " << dropped << " oldest event(s)\n";
+                }
+            }
+        } finish_run{metrics_path, trace_path};
+        
+        // Machine-readable output streams through a sink instead of the table
+        BufferedWriter out(STDOUT_FILENO);
+        NdjsonSink ndjson(out);
+        CsvSink csv(out);
+        ResultSink* format_sink = nullptr;
+        if (output_format == "ndjson") format_sink = &ndjson;
+        if (output_format == "csv") format_sink = &csv;
+        OrderedSink ordered(format_sink ? *format_sink : static_cast<ResultSink&>(ndjson));
+        
+        if (format_sink) {
+            scan_options.verbose = false;
+            scan_options.sink = ordered_output ? static_cast<ResultSink*>(&ordered) : format_sink;
+        }
+        
+        // Scan one address and print or stream its results
+        auto scan_address = [&](const std::string& addr, const std::string& banner) {
+            if (!format_sink) {
+                std::cout << banner;
+            }
+            
+            std::vector<ChainResult> results;
+            if (daemon_client) {
+                DaemonProtocol::ScanRequest request;
+                request.address = addr;
+                request.include_testnets = scan_options.include_testnets;
+                request.only_with_activity = scan_options.only_with_activity;
+                request.proof = query.plan == QueryPlan::Proof;
+                request.offline = scan_options.offline;
+                request.skip_empty = skip_empty_requested;
+                request.threads = threads_set ? static_cast<uint16_t>(num_threads) : 0;
+                request.cache_ttl_blocks = scan_options.cache_ttl_blocks;
+                request.reverify_rate = scan_options.reverify_rate;
+                request.top_k = static_cast<uint32_t>(scan_options.top_k);
+                
+                // The daemon streams in completion order; ordered output waits for the end
+                bool stream = format_sink && !ordered_output;
+                if (format_sink) format_sink->begin(addr, 0);
+                
+                std::string error;
+                bool ok = ScanDaemon::request_scan(socket_path, request, [&](const ChainResult& result) {
+                    if (stream) {
+                        format_sink->complete(0, &result);
+                        return;
+                    }
+                    results.push_back(result);
+                    if (!format_sink) {
+                        std::cout << "\rReceived " << results.size() << " result(s)" << std::flush;
+                    }
+                }, error);
+                if (!format_sink && !results.empty()) std::cout << "\n";
+                if (!ok) {
+                    if (format_sink) format_sink->end();
+                    std::cerr << "Error: " << error << "\n";
+                    return false;
+                }
+                
+                std::sort(results.begin(), results.end(), [](const ChainResult& a, const ChainResult& b) {
+                    return a.chain_id < b.chain_id;
+                });
+                if (format_sink) {
+                    for (const auto& result : results) {
+                        format_sink->complete(0, &result);
+                    }
+                    format_sink->end();
+                    return true;
+                }
+            } else {
+                results = MultiChainChecker::scan_all(addr, scan_options);
+                if (format_sink) return true;
+            }
+            MultiChainChecker::print_results(results);
+            return true;
+        };
+        
+        auto address_banner = [](const std::string& position, const std::string& addr) {
+            return "\n" + std::string(80, '=') + "\n" +
+                   "=== Scanning address " + position + ": " + addr + " ===\n" +
+                   std::string(80, '=') + "\n";
+        };
+        
+        // Several addresses are scanned as one address x chain matrix and
+        // reported as each address completes
+        std::string position_suffix;
+        std::mutex output_mutex;
+        auto on_address_done = [&](const std::string& addr, uint64_t index, std::vector<ChainResult>& results) {
+            std::lock_guard<std::mutex> lock(output_mutex);
+            if (format_sink) {
+                format_sink->begin(addr, results.size());
+                for (size_t i = 0; i < results.size(); i++) {
+                    format_sink->complete(i, &results[i]);
+                }
+                format_sink->end();
+            } else {
+                std::cout << address_banner(std::to_string(index + 1) + position_suffix, addr);
+                MultiChainChecker::print_results(results);
+            }
+        };
+        auto announce = [&](const ScanScheduler& scheduler) {
+            if (!format_sink) {
+                std::cout << "Scanning " << scheduler.chain_count() << " chains per address with "
+                          << num_threads << " thread(s), " << scheduler.batch_addresses() << " address(es) per request...\n" << std::flush;
+            }
+        };
+        
+        // Addresses from a file or stdin run through the input pipeline
+        if (!input_path.empty()) {
+            InputStats stats;
+            bool failed = false;
+            bool read_ok;
+            if (daemon_client) {
+                read_ok = AddressInput::run_pipeline(input_path, [&](const InputAddress& item) {
+                    failed = !scan_address(item.address, address_banner(std::to_string(item.index + 1), item.address));
+                    return !failed;
+                }, stats);
+            } else {
+                ScanScheduler scheduler(scan_options, on_address_done, batch_addresses);
+                announce(scheduler);
+                read_ok = AddressInput::run_pipeline(input_path, [&](const InputAddress& item) {
+                    scheduler.add(item.address, item.index);
+                    return true;
+                }, stats);
+                scheduler.finish();
+            }
+            out.flush();
+            
+            std::cerr << "Processed " << stats.scanned << " address(es) from " << stats.tokens << " token(s)";
+            if (stats.invalid > 0 || stats.bad_checksum > 0) {
+                std::cerr << ", skipped " << stats.invalid << " invalid and " << stats.bad_checksum << " with a bad checksum";
+            }
+            std::cerr << "\n";
+            ConcurrencyControl::print_summary(std::cerr);
+            return (read_ok && !failed) ? 0 : 1;
+        }
+        
         // parse comma-separated addresses
         auto addresses = split_addresses(std::string(address));
+        bool addresses_done = false;
         
         if (addresses.empty()) {
             std::cerr << "Error: No valid addresses provided\n";
@@ -145,26 +725,37 @@ int main(int argc, char *argv[]) {
             }
         }
         
+        if (addresses.size() > 1 && !daemon_client) {
+            position_suffix = "/" + std::to_string(addresses.size());
+            ScanScheduler scheduler(scan_options, on_address_done, batch_addresses);
+            announce(scheduler);
+            for (size_t i = 0; i < addresses.size(); i++) {
+                scheduler.add(addresses[i], i);
+            }
+            scheduler.finish();
+            addresses_done = true;
+        }
+        
         // scan each address
-        for (size_t i = 0; i < addresses.size(); i++) {
-            if (addresses.size() > 1) {
-                std::cout << "\n" << std::string(80, '=') << "\n";
-                std::cout << "=== Scanning address " << (i + 1) << "/" << addresses.size() << ": " << addresses[i] << " ===\n";
-                std::cout << std::string(80, '=') << "\n";
-            } else {
-                std::cout << "\nScanning address across all chains (including testnets)...\n";
+        for (size_t i = 0; i < addresses.size() && !addresses_done; i++) {
+            std::string banner = addresses.size() > 1
+                ? address_banner(std::to_string(i + 1) + "/" + std::to_string(addresses.size()), addresses[i])
+                : "\nScanning address across all chains (including testnets)...\n";
+            if (!scan_address(addresses[i], banner)) {
+                return 1;
             }
-            
-            auto results = MultiChainChecker::scan_all(addresses[i], true, true, num_threads);
-            MultiChainChecker::print_results(results);
         }
         
-        if (addresses.size() > 1) {
+        if (format_sink) {
+            out.flush();
+        } else if (addresses.size() > 1) {
             std::cout << "\n" << std::string(80, '=') << "\n";
             std::cout << "=== Completed scanning " << addresses.size() << " addresses ===\n";
             std::cout << std::string(80, '=') << "\n";
         }
         
+        // Machine-readable stdout stays clean; the stats go to stderr
+        ConcurrencyControl::print_summary(format_sink ? std::cerr : std::cout);
         return 0;
     }
     
@@ -198,6 +789,9 @@ int main(int argc, char *argv[]) {
     
     // Check address info via RPC
     if (info_chain_id > 0) {
+        // Only the one chain is decoded from the registry snapshot
+        init_registry();
+        
         auto chain = ChainRegistry::get_by_id(info_chain_id);
         if (!chain) {
             std::cerr << "Error: Chain ID " << info_chain_id << " not found\n";
@@ -221,13 +815,9 @@ int main(int argc, char *argv[]) {
             // Skip wss endpoints
             if (rpc_url.find("wss://") == 0) continue;
             
-            info = RpcClient::check_address(rpc_url, std::string(address));
-            if (!info.balance_wei.empty() && info.balance_wei != "0x0" && info.balance_eth != "0") {
-                success = true;
-                break;
-            }
-            // If balance is 0 but we got a response, also consider it success
-            if (!info.balance_wei.empty()) {
+            info = RpcClient::check_address(rpc_url, std::string(address), query);
+            // A zero balance is also a valid response
+            if (info.ok) {
                 success = true;
                 break;
             }
@@ -238,8 +828,39 @@ int main(int argc, char *argv[]) {
             return 1;
         }
         
-        std::cout << "Balance: " << info.balance_eth << " " << chain->symbol << "\n";
+        std::cout << "Balance: " << info.balance.format_units(chain->decimals) << " " << chain->symbol << "\n";
         std::cout << "TX Count: " << info.tx_count << "\n";
+        if (!info.code_hash.empty()) {
+            std::cout << "Type: " << (info.is_contract ? "Contract" : "EOA") << "\n";
+        }
+        
+        if (find_activity) {
+            std::cout << "\nSearching activity range...\n";
+            
+            // Historical state needs an archive node - try endpoints until one answers
+            std::optional<ActivityRange> range;
+            for (const auto& rpc_url : chain->rpc_urls) {
+                if (rpc_url.find("http") != 0) continue;
+                
+                range = ActivityFinder::find_range(rpc_url, std::string(address));
+                if (range) break;
+            }
+            
+            if (!range) {
+                std::cerr << "Warning: No RPC endpoint with historical state available\n";
+                return 1;
+            }
+            
+            if (!range->has_activity) {
+                std::cout << "No activity up to block " << range->latest_block << "\n";
+            } else {
+                std::cout << "First active: block " << range->first_block
+                          << " (" << format_timestamp(range->first_timestamp) << ")\n";
+                std::cout << "Last active:  block " << range->last_block
+                          << " (" << format_timestamp(range->last_timestamp) << ")\n";
+            }
+            std::cout << "Round trips: " << range->round_trips << "\n";
+        }
     }
     
     return 0;
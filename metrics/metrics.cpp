@@ -0,0 +1,316 @@
+#include "metrics.hpp"
+#include "../probe/endpoint_probe.hpp"
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+// ---------------------------------------------------------------------------
+// LatencyHistogram
+// ---------------------------------------------------------------------------
+
+size_t LatencyHistogram::index_of(uint64_t micros) {
+    if (micros < SUB_BUCKETS) {
+        return static_cast<size_t>(micros);
+    }
+    // Highest set bit picks the power of two, the next 3 bits the sub-bucket
+    int magnitude = 63 - __builtin_clzll(micros) - SUB_BUCKET_BITS;
+    size_t sub = static_cast<size_t>(micros >> magnitude) & (SUB_BUCKETS - 1);
+    size_t index = SUB_BUCKETS + static_cast<size_t>(magnitude) * SUB_BUCKETS + sub;
+    return index < BUCKETS ? index : BUCKETS - 1;
+}
+
+uint64_t LatencyHistogram::upper_bound_of(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    size_t magnitude = (index - SUB_BUCKETS) / SUB_BUCKETS;
+    size_t sub = (index - SUB_BUCKETS) % SUB_BUCKETS;
+    uint64_t lower = (SUB_BUCKETS + sub) << magnitude;
+    return lower + (uint64_t{1} << magnitude) - 1;
+}
+
+void LatencyHistogram::record(double seconds) {
+    if (!(seconds >= 0.0)) return;
+    uint64_t micros = static_cast<uint64_t>(seconds * 1e6 + 0.5);
+    buckets_[index_of(micros)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_micros_.fetch_add(micros, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count_at_or_below(double seconds) const {
+    uint64_t bound = static_cast<uint64_t>(seconds * 1e6 + 0.5);
+    uint64_t total = 0;
+    for (size_t i = 0; i < BUCKETS && upper_bound_of(i) <= bound; i++) {
+        total += buckets_[i].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+double LatencyHistogram::quantile(double q) const {
+    uint64_t n = count();
+    if (n == 0) return 0.0;
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(n) + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) return upper_bound_of(i) / 1e6;
+    }
+    return upper_bound_of(BUCKETS - 1) / 1e6;
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_micros_.store(0, std::memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------------------
+// Registry
+// ---------------------------------------------------------------------------
+
+namespace {
+
+enum Phase { PHASE_DNS, PHASE_CONNECT, PHASE_TLS, PHASE_TTFB, PHASE_TRANSFER, PHASE_PARSE, PHASE_TOTAL, PHASE_COUNT };
+
+const char* const PHASE_NAMES[PHASE_COUNT] = {"dns", "connect", "tls", "ttfb", "transfer", "parse", "total"};
+
+constexpr size_t FAILURE_COUNT = static_cast<size_t>(FailureClass::Count);
+const char* const FAILURE_NAMES[FAILURE_COUNT] = {"none", "timeout", "rate_limited", "http", "transport", "parse"};
+
+constexpr size_t OUTCOME_COUNT = static_cast<size_t>(ChainOutcome::Count);
+const char* const OUTCOME_NAMES[OUTCOME_COUNT] = {"active", "empty", "cached", "failed"};
+
+// Prometheus buckets, in seconds
+const double EXPORT_BOUNDS[] = {0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+
+struct HostMetrics {
+    LatencyHistogram phases[PHASE_COUNT];
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> failures[FAILURE_COUNT] = {};
+    std::atomic<uint64_t> bytes_sent{0};
+    std::atomic<uint64_t> bytes_received{0};
+};
+
+struct ChainMetrics {
+    LatencyHistogram duration;
+    std::atomic<uint64_t> outcomes[OUTCOME_COUNT] = {};
+};
+
+std::atomic<bool> g_enabled{false};
+std::shared_mutex g_mutex;
+std::map<std::string, std::unique_ptr<HostMetrics>> g_hosts;
+std::map<uint64_t, std::unique_ptr<ChainMetrics>> g_chains;
+std::atomic<uint64_t> g_retries_rate_limit{0};
+std::atomic<uint64_t> g_retries_fallback{0};
+LatencyHistogram g_all_chains;
+
+volatile std::sig_atomic_t g_dump_requested = 0;
+
+// Entries are never removed, so the pointer stays valid after unlocking
+template <typename Key, typename Value>
+Value& find_or_add(std::map<Key, std::unique_ptr<Value>>& map, const Key& key) {
+    {
+        std::shared_lock<std::shared_mutex> lock(g_mutex);
+        auto it = map.find(key);
+        if (it != map.end()) return *it->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(g_mutex);
+    auto& slot = map[key];
+    if (!slot) slot = std::make_unique<Value>();
+    return *slot;
+}
+
+HostMetrics& host_metrics(const std::string& rpc_url) {
+    return find_or_add(g_hosts, EndpointProbe::endpoint_host(rpc_url));
+}
+
+// Label values are hostnames and fixed names; escape anyway
+std::string escape_label(const std::string& value) {
+    std::string out;
+    for (char c : value) {
+        if (c == '\\' || c == '"') out += '\\';
+        if (c == '\n') { out += "\\n"; continue; }
+        out += c;
+    }
+    return out;
+}
+
+void write_histogram(std::ostream& out, const char* name, const std::string& labels, const LatencyHistogram& h) {
+    std::string prefix = labels.empty() ? "" : labels + ",";
+    for (double bound : EXPORT_BOUNDS) {
+        out << name << "_bucket{" << prefix << "le=\"" << bound << "\"} " << h.count_at_or_below(bound) << "\n";
+    }
+    out << name << "_bucket{" << prefix << "le=\"+Inf\"} " << h.count() << "\n";
+    out << name << "_sum{" << labels << "} " << h.sum() << "\n";
+    out << name << "_count{" << labels << "} " << h.count() << "\n";
+}
+
+void write_header(std::ostream& out, const char* name, const char* type, const char* help) {
+    out << "# HELP " << name << " " << help << "\n"
+        << "# TYPE " << name << " " << type << "\n";
+}
+
+} // anonymous namespace
+
+namespace Metrics {
+
+void enable() {
+    g_enabled.store(true, std::memory_order_relaxed);
+}
+
+bool enabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+void record_request(const std::string& rpc_url, const RequestTiming& timing, FailureClass failure) {
+    if (!enabled()) return;
+    HostMetrics& m = host_metrics(rpc_url);
+    m.requests.fetch_add(1, std::memory_order_relaxed);
+    if (failure != FailureClass::None) {
+        m.failures[static_cast<size_t>(failure)].fetch_add(1, std::memory_order_relaxed);
+    }
+    m.bytes_sent.fetch_add(timing.bytes_sent, std::memory_order_relaxed);
+    m.bytes_received.fetch_add(timing.bytes_received, std::memory_order_relaxed);
+
+    // Connection phases only exist for requests that reached the server
+    if (failure == FailureClass::Transport || failure == FailureClass::Timeout) {
+        m.phases[PHASE_TOTAL].record(timing.total);
+        return;
+    }
+    m.phases[PHASE_DNS].record(timing.dns);
+    m.phases[PHASE_CONNECT].record(timing.connect);
+    if (timing.tls > 0.0) {
+        m.phases[PHASE_TLS].record(timing.tls);
+    }
+    m.phases[PHASE_TTFB].record(timing.ttfb);
+    m.phases[PHASE_TRANSFER].record(timing.transfer);
+    m.phases[PHASE_TOTAL].record(timing.total);
+}
+
+void record_parse(const std::string& rpc_url, double seconds, bool ok) {
+    if (!enabled()) return;
+    HostMetrics& m = host_metrics(rpc_url);
+    m.phases[PHASE_PARSE].record(seconds);
+    if (!ok) {
+        m.failures[static_cast<size_t>(FailureClass::Parse)].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void record_retry(const char* reason) {
+    if (!enabled()) return;
+    std::string r = reason;
+    (r == "rate_limit" ? g_retries_rate_limit : g_retries_fallback).fetch_add(1, std::memory_order_relaxed);
+}
+
+void record_chain(uint64_t chain_id, double seconds, ChainOutcome outcome) {
+    if (!enabled()) return;
+    ChainMetrics& m = find_or_add(g_chains, chain_id);
+    m.duration.record(seconds);
+    g_all_chains.record(seconds);
+    m.outcomes[static_cast<size_t>(outcome)].fetch_add(1, std::memory_order_relaxed);
+}
+
+const LatencyHistogram& chain_latency() {
+    return g_all_chains;
+}
+
+void reset() {
+    std::unique_lock<std::shared_mutex> lock(g_mutex);
+    g_hosts.clear();
+    g_chains.clear();
+    g_retries_rate_limit.store(0);
+    g_retries_fallback.store(0);
+    g_all_chains.reset();
+}
+
+void write_prometheus(std::ostream& out) {
+    std::shared_lock<std::shared_mutex> lock(g_mutex);
+
+    write_header(out, "checker_rpc_requests_total", "counter", "HTTP requests sent to RPC endpoints");
+    for (const auto& [host, m] : g_hosts) {
+        out << "checker_rpc_requests_total{host=\"" << escape_label(host) << "\"} " << m->requests.load() << "\n";
+    }
+
+    write_header(out, "checker_rpc_failures_total", "counter", "Requests without a usable answer, by class");
+    for (const auto& [host, m] : g_hosts) {
+        for (size_t i = 1; i < FAILURE_COUNT; i++) {
+            uint64_t n = m->failures[i].load();
+            if (n == 0) continue;
+            out << "checker_rpc_failures_total{host=\"" << escape_label(host) << "\",class=\""
+                << FAILURE_NAMES[i] << "\"} " << n << "\n";
+        }
+    }
+
+    write_header(out, "checker_rpc_retries_total", "counter", "Requests repeated after a failure");
+    out << "checker_rpc_retries_total{reason=\"rate_limit\"} " << g_retries_rate_limit.load() << "\n"
+        << "checker_rpc_retries_total{reason=\"fallback\"} " << g_retries_fallback.load() << "\n";
+
+    write_header(out, "checker_rpc_bytes_total", "counter", "Request and response body bytes");
+    for (const auto& [host, m] : g_hosts) {
+        std::string label = "host=\"" + escape_label(host) + "\"";
+        out << "checker_rpc_bytes_total{" << label << ",direction=\"sent\"} " << m->bytes_sent.load() << "\n"
+            << "checker_rpc_bytes_total{" << label << ",direction=\"received\"} " << m->bytes_received.load() << "\n";
+    }
+
+    write_header(out, "checker_rpc_phase_seconds", "histogram", "Time spent in each phase of a request");
+    for (const auto& [host, m] : g_hosts) {
+        for (size_t p = 0; p < PHASE_COUNT; p++) {
+            if (m->phases[p].count() == 0) continue;
+            std::string labels = "host=\"" + escape_label(host) + "\",phase=\"" + PHASE_NAMES[p] + "\"";
+            write_histogram(out, "checker_rpc_phase_seconds", labels, m->phases[p]);
+        }
+    }
+
+    write_header(out, "checker_chain_scans_total", "counter", "Chain scans by outcome");
+    for (const auto& [chain_id, m] : g_chains) {
+        for (size_t i = 0; i < OUTCOME_COUNT; i++) {
+            uint64_t n = m->outcomes[i].load();
+            if (n == 0) continue;
+            out << "checker_chain_scans_total{chain_id=\"" << chain_id << "\",outcome=\""
+                << OUTCOME_NAMES[i] << "\"} " << n << "\n";
+        }
+    }
+
+    write_header(out, "checker_chain_scan_seconds", "histogram", "Time to answer one chain, including fallbacks");
+    for (const auto& [chain_id, m] : g_chains) {
+        write_histogram(out, "checker_chain_scan_seconds", "chain_id=\"" + std::to_string(chain_id) + "\"", m->duration);
+    }
+}
+
+bool write_file(const std::string& path) {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp);
+        if (!out) return false;
+        write_prometheus(out);
+        if (!out) return false;
+    }
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+void dump_on_signal(const std::string& path) {
+    static std::once_flag once;
+    std::call_once(once, [path]() {
+        std::signal(SIGUSR1, [](int) { g_dump_requested = 1; });
+        std::thread([path]() {
+            for (;;) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                if (g_dump_requested) {
+                    g_dump_requested = 0;
+                    write_file(path);
+                }
+            }
+        }).detach();
+    });
+}
+
+} // namespace Metrics
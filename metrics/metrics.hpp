@@ -0,0 +1,163 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * Lock-free latency histogram with HDR-style log-linear buckets
+ * Each power of two is split into 8 sub-buckets, so any recorded value
+ * is known within 12.5%, from 1 us up to about 38 hours.
+ */
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 3;
+    static constexpr size_t SUB_BUCKETS = size_t{1} << SUB_BUCKET_BITS;
+    static constexpr size_t MAGNITUDES = 35;
+    static constexpr size_t BUCKETS = SUB_BUCKETS + MAGNITUDES * SUB_BUCKETS;
+
+    /**
+     * Record a duration
+     * @param seconds Duration; negative values are ignored
+     */
+    void record(double seconds);
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    double sum() const { return sum_micros_.load(std::memory_order_relaxed) / 1e6; }
+
+    /**
+     * Values recorded in buckets that end at or below a bound
+     */
+    uint64_t count_at_or_below(double seconds) const;
+
+    /**
+     * Upper bound of the bucket holding the q-th quantile (0..1), in seconds
+     */
+    double quantile(double q) const;
+
+    /**
+     * Forget every recorded value (not atomic with concurrent record())
+     */
+    void reset();
+
+private:
+    static size_t index_of(uint64_t micros);
+    static uint64_t upper_bound_of(size_t index);
+
+    std::array<std::atomic<uint64_t>, BUCKETS> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_micros_{0};
+};
+
+/**
+ * Phases of one HTTP request, from curl's write-out timers, in seconds
+ */
+struct RequestTiming {
+    double dns = 0.0;        // name lookup
+    double connect = 0.0;    // TCP handshake
+    double tls = 0.0;        // TLS handshake (0 for plain HTTP)
+    double ttfb = 0.0;       // request sent until the first response byte
+    double transfer = 0.0;   // first to last response byte
+    double total = 0.0;
+    uint64_t bytes_sent = 0;
+    uint64_t bytes_received = 0;
+};
+
+/**
+ * Why a request did not produce a usable answer
+ */
+enum class FailureClass {
+    None,
+    Timeout,      // transport timeout
+    RateLimited,  // HTTP 429 or 503
+    Http,         // any other non-200 status
+    Transport,    // refused, DNS failure, reset
+    Parse,        // body was not valid JSON
+    Count
+};
+
+/**
+ * How a chain of a scan ended
+ */
+enum class ChainOutcome {
+    Active,   // balance or nonce
+    Empty,
+    Cached,   // answered by the result cache or empty filter
+    Failed,   // no endpoint answered
+    Count
+};
+
+/**
+ * Process-wide scan metrics, exported in the Prometheus text format
+ *
+ * Request phases are kept per endpoint host (chain lists name thousands
+ * of URLs but far fewer hosts), chain durations per chain ID. Recording
+ * is a no-op until enable().
+ */
+namespace Metrics {
+
+/**
+ * Start recording
+ */
+void enable();
+
+bool enabled();
+
+/**
+ * Record one HTTP request
+ * @param rpc_url Endpoint; metrics are labelled by its host
+ */
+void record_request(const std::string& rpc_url, const RequestTiming& timing, FailureClass failure);
+
+/**
+ * Record parsing a response body
+ * @param ok false if the body was not valid JSON (counted as a Parse failure)
+ */
+void record_parse(const std::string& rpc_url, double seconds, bool ok);
+
+/**
+ * Count a retry
+ * @param reason "rate_limit" (same endpoint) or "fallback" (next endpoint)
+ */
+void record_retry(const char* reason);
+
+/**
+ * Record how long a chain took to answer, including endpoint fallbacks
+ */
+void record_chain(uint64_t chain_id, double seconds, ChainOutcome outcome);
+
+/**
+ * Scan time of every chain so far, across all chains
+ */
+const LatencyHistogram& chain_latency();
+
+/**
+ * Forget everything recorded so far, e.g. between benchmark runs
+ * Call while no scan is running.
+ */
+void reset();
+
+/**
+ * Write all metrics in the Prometheus text exposition format (0.0.4)
+ */
+void write_prometheus(std::ostream& out);
+
+/**
+ * Write the exposition to a file, replacing it atomically
+ * @return true if the file was written
+ */
+bool write_file(const std::string& path);
+
+/**
+ * Write the file whenever the process receives SIGUSR1
+ * A background thread does the writing, outside the signal handler.
+ */
+void dump_on_signal(const std::string& path);
+
+} // namespace Metrics
+
+#endif // METRICS_HPP
@@ -19,7 +19,7 @@ struct Rpc {
 struct NativeCurrency {
     std::string name;
     std::string symbol;
-    int decimals;
+    int decimals = 18;
 };
 
 struct Explorer {
@@ -1,169 +1,447 @@
 #include "multi_checker.hpp"
 #include "../chain/chain.hpp"
 #include "../rpc/rpc.hpp"
+#include "../cache/result_cache.hpp"
+#include "../probe/endpoint_probe.hpp"
+#include "../output/result_sink.hpp"
+#include "../output/progress.hpp"
+#include "../pool/worker_pool.hpp"
+#include "../scheduler/work_stealing.hpp"
+#include "../priority/chain_priority.hpp"
+#include "../metrics/metrics.hpp"
+#include "../trace/trace.hpp"
 #include <iostream>
 #include <iomanip>
-#include <thread>
+#include <future>
+#include <iterator>
 #include <mutex>
 #include <atomic>
 #include <algorithm>
-#include <mutex>
-#include <atomic>
-#include <queue>
-#include <condition_variable>
+#include <chrono>
+#include <random>
+#include <unordered_map>
+#include <unistd.h>
 
 namespace MultiChainChecker {
 
-// Thread-safe counters
-static std::mutex cout_mutex;
-static std::mutex results_mutex;
-static std::atomic<size_t> completed_count(0);
+static std::mutex pool_mutex;
+static std::shared_ptr<WorkerPool> shared_pool;
 
+// Per-scan state shared by the workers of one scan_all call
+struct ScanState {
+    std::atomic<size_t> skipped_empty_count{0};
+    std::vector<std::vector<ChainResult>> results;  // one buffer per worker, merged at the end
+};
 
+bool init_pool(size_t workers) {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    if (shared_pool) {
+        return false;
+    }
+    shared_pool = std::make_shared<WorkerPool>(workers);
+    return true;
+}
 
-// Worker function to process a single chain
-static void process_chain(const Chain& chain, 
-                          const std::string& address,
-                          std::vector<ChainResult>& results,
-                          bool only_with_activity) {
-    
-    // Try each RPC endpoint until we get valid data
-    AddressInfo info;
-    bool got_valid_response = false;
+std::shared_ptr<WorkerPool> pool() {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    if (!shared_pool) {
+        shared_pool = std::make_shared<WorkerPool>(DEFAULT_WORKERS);
+    }
+    return shared_pool;
+}
+
+void shutdown_pool() {
+    std::shared_ptr<WorkerPool> stopping;
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        stopping.swap(shared_pool);
+    }
+    if (stopping) {
+        stopping->shutdown();
+    }
+}
+
+// Decide whether a pair the empty filter knows about is queried anyway
+static bool should_reverify(double rate) {
+    if (rate <= 0.0) return false;
+    thread_local std::mt19937_64 rng(std::random_device{}());
+    return std::uniform_real_distribution<double>(0.0, 1.0)(rng) < rate;
+}
+
+std::optional<AddressInfo> cached_info(const Chain& chain,
+                                       const std::string& address,
+                                       const ScanOptions& options,
+                                       bool& known_empty) {
+    known_empty = false;
     
-    for (const auto& rpc_url : chain.rpc_urls) {
-        // Skip non-HTTP endpoints
-        if (rpc_url.find("http") != 0) continue;
-        if (rpc_url.find("wss://") == 0) continue;
-        if (rpc_url.find("${") != std::string::npos) continue;
-        if (rpc_url.find("{") != std::string::npos) continue;
-        
-        // Query the RPC (no display, just try it)
-        info = RpcClient::check_address(rpc_url, address);
-        
-        // Check if we got a valid response
-        if (!info.balance_wei.empty()) {
-            got_valid_response = true;
-            break;  // Success - move to next chain
+    // Result cache first - offline scans accept entries of any age
+    if (ResultCache::is_open()) {
+        uint64_t max_age = options.offline ? UINT64_MAX / 2 : ResultCache::ttl_for(chain.chain_id, options.cache_ttl_blocks);
+        auto cached = ResultCache::lookup(chain.chain_id, address, max_age);
+        // A Batch-plan entry cannot tell a contract from an EOA, so a Proof scan
+        // re-queries it (and an offline one leaves it out) rather than report an EOA
+        if (cached && options.query.plan == QueryPlan::Proof && !cached->contract_known) {
+            cached.reset();
+        }
+        if (cached) {
+            AddressInfo info;
+            info.ok = true;
+            info.balance = cached->balance;
+            info.tx_count = cached->tx_count;
+            info.is_contract = cached->is_contract;
+            info.block_number = cached->block;
+            return info;
         }
-        // RPC failed - try next RPC
     }
     
-    if (!got_valid_response) {
-        return;  // All RPCs failed for this chain
+    // Known-empty pairs are answered as empty without a request
+    if (options.skip_empty && EmptyFilter::is_open() &&
+        EmptyFilter::contains(chain.chain_id, address) && !should_reverify(options.reverify_rate)) {
+        known_empty = true;
+        AddressInfo info;
+        info.ok = true;
+        return info;
+    }
+    
+    return std::nullopt;
+}
+
+void record_info(const Chain& chain, const std::string& address, const AddressInfo& info) {
+    if (ResultCache::is_open()) {
+        CachedState cached;
+        cached.balance = info.balance;
+        cached.tx_count = info.tx_count;
+        cached.is_contract = info.is_contract;
+        cached.contract_known = !info.code_hash.empty();
+        cached.block = info.block_number;
+        ResultCache::store(chain.chain_id, address, cached);
     }
     
+    if (EmptyFilter::is_open() && info.balance.is_zero() && info.tx_count == 0) {
+        EmptyFilter::insert(chain.chain_id, address);
+    }
+}
+
+std::optional<ChainResult> make_result(const Chain& chain,
+                                       const AddressInfo& info,
+                                       bool from_cache,
+                                       const ScanOptions& options) {
     // Check if there's any activity
-    bool has_activity = (info.balance_eth != "0" && !info.balance_eth.empty()) 
-                       || info.tx_count > 0;
+    bool has_activity = !info.balance.is_zero() || info.tx_count > 0;
     
     // Skip if filtering and no activity
-    if (only_with_activity && !has_activity) {
-        return;
+    if (options.only_with_activity && !has_activity) {
+        return std::nullopt;
     }
     
     ChainResult result;
     result.chain_id = chain.chain_id;
     result.chain_name = chain.name;
     result.symbol = chain.symbol;
-    result.balance_eth = info.balance_eth.empty() ? "0" : info.balance_eth;
+    result.balance = info.balance;
+    result.decimals = chain.decimals;
     result.tx_count = info.tx_count;
     result.is_contract = info.is_contract;
     result.has_activity = has_activity;
     result.explorer_url = chain.explorer_url;
+    result.block_number = info.block_number;
+    result.from_cache = from_cache;
     
-    // Thread-safe add to results
-    {
-        std::lock_guard<std::mutex> lock(results_mutex);
-        results.push_back(result);
+    return result;
+}
+
+// Time from the start of a chain's scan to its answer, for the metrics
+static void record_scan(const Chain& chain, std::chrono::steady_clock::time_point start, ChainOutcome outcome) {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    Metrics::record_chain(chain.chain_id, elapsed.count(), outcome);
+}
+
+// Worker function to process a single chain
+static std::optional<ChainResult> process_chain(const Chain& chain, 
+                                                const std::string& address,
+                                                ScanState& state,
+                                                const ScanOptions& options) {
+    auto scan_start = std::chrono::steady_clock::now();
+    bool known_empty = false;
+    if (auto cached = cached_info(chain, address, options, known_empty)) {
+        if (known_empty) state.skipped_empty_count++;
+        record_scan(chain, scan_start, ChainOutcome::Cached);
+        return make_result(chain, *cached, true, options);
     }
+    
+    if (options.offline) {
+        return std::nullopt;
+    }
+    
+    // Try each RPC endpoint until we get valid data
+    bool first = true;
+    for (const auto& rpc_url : chain.rpc_urls) {
+        // Skip non-HTTP endpoints
+        if (!EndpointProbe::is_http_endpoint(rpc_url)) continue;
+        if (!first) Metrics::record_retry("fallback");
+        first = false;
+        
+        // Query the RPC (no display, just try it)
+        std::string host = Trace::enabled() ? EndpointProbe::endpoint_host(rpc_url) : "";
+        Trace::Span attempt("attempt", "scan", host, {chain.chain_id});
+        auto start = std::chrono::steady_clock::now();
+        AddressInfo info = RpcClient::check_address(rpc_url, address, options.query);
+        if (info.ok) {
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            bool has_activity = !info.balance.is_zero() || info.tx_count > 0;
+            ChainPriority::record(chain.chain_id, has_activity, elapsed.count());
+            record_info(chain, address, info);
+            record_scan(chain, scan_start, has_activity ? ChainOutcome::Active : ChainOutcome::Empty);
+            return make_result(chain, info, false, options);
+        }
+        // RPC failed - try next RPC
+    }
+    
+    record_scan(chain, scan_start, ChainOutcome::Failed);
+    return std::nullopt;  // All RPCs failed for this chain
 }
 
-std::vector<ChainResult> scan_all(const std::string& address,
-                                   bool include_testnets,
-                                   bool only_with_activity,
-                                   size_t num_threads) {
-    std::vector<ChainResult> results;
-    const auto& chains = ChainRegistry::get_all();
+std::vector<const Chain*> select_chains(const ScanOptions& options, std::vector<Chain>& probed) {
+    const auto& chains = options.chains ? *options.chains : ChainRegistry::get_all();
     
     // Filter chains first
-    std::vector<std::pair<size_t, const Chain*>> valid_chains;
-    for (size_t i = 0; i < chains.size(); i++) {
-        const auto& chain = chains[i];
-        
+    std::vector<const Chain*> valid_chains;
+    for (const auto& chain : chains) {
         // Skip testnets if not requested
-        if (!include_testnets && chain.is_testnet) {
-            continue;
-        }
-        
-        // Skip chains without RPC endpoints
-        if (chain.rpc_urls.empty()) {
+        if (!options.include_testnets && chain.is_testnet) {
             continue;
         }
         
         // Check if chain has valid HTTP endpoints
         bool has_http = false;
         for (const auto& rpc_url : chain.rpc_urls) {
-            if (rpc_url.find("http") == 0 && 
-                rpc_url.find("wss://") != 0 &&
-                rpc_url.find("${") == std::string::npos &&
-                rpc_url.find("{") == std::string::npos) {
+            if (EndpointProbe::is_http_endpoint(rpc_url)) {
                 has_http = true;
                 break;
             }
         }
         
         if (has_http) {
-            valid_chains.push_back({i + 1, &chain});
+            valid_chains.push_back(&chain);
+        }
+    }
+    
+    // Drop dead and misconfigured endpoints up front so workers do not
+    // spend a timeout on each of them
+    if (options.probe_endpoints && !options.offline && !valid_chains.empty()) {
+        if (options.verbose) {
+            std::cout << "Probing endpoints of " << valid_chains.size() << " chains...\n" << std::flush;
+        }
+        ProbeSummary summary;
+        probed = EndpointProbe::prune(valid_chains, &summary, options.probe_timeout);
+        if (options.verbose) {
+            std::cout << "Probe: " << summary.alive << "/" << summary.endpoints << " endpoints alive, "
+                      << summary.wrong_chain << " wrong chain, " << summary.dead << " dead, "
+                      << summary.chains_lost << " chain(s) without a live endpoint\n";
+        }
+        
+        valid_chains.clear();
+        for (const auto& chain : probed) {
+            valid_chains.push_back(&chain);
         }
     }
     
+    // Chain ID order, so sinks can number chains and reorder cheaply
+    std::sort(valid_chains.begin(), valid_chains.end(), [](const Chain* a, const Chain* b) {
+        return a->chain_id < b->chain_id;
+    });
+    
+    return valid_chains;
+}
+
+// Group chains by the host of their first endpoint and deal the groups
+// out to the workers, largest first to the least loaded one, so a worker
+// keeps talking to the same provider and slow providers do not stall
+// every worker at once. Tasks are ranks into `order`; each deque ends up
+// in rank order.
+static void assign_by_host(const std::vector<const Chain*>& chains,
+                           const std::vector<size_t>& order,
+                           WorkStealingDeques<size_t>& deques) {
+    std::unordered_map<std::string, size_t> group_of;
+    std::vector<std::vector<size_t>> groups;
+    for (size_t rank = 0; rank < order.size(); rank++) {
+        std::string host;
+        for (const auto& rpc_url : chains[order[rank]]->rpc_urls) {
+            if (EndpointProbe::is_http_endpoint(rpc_url)) {
+                host = EndpointProbe::endpoint_host(rpc_url);
+                break;
+            }
+        }
+        auto [it, inserted] = group_of.emplace(host, groups.size());
+        if (inserted) {
+            groups.emplace_back();
+        }
+        groups[it->second].push_back(rank);
+    }
+    
+    std::stable_sort(groups.begin(), groups.end(), [](const auto& a, const auto& b) {
+        return a.size() > b.size();
+    });
+    
+    std::vector<std::vector<size_t>> lanes(deques.workers());
+    for (const auto& group : groups) {
+        auto lane = std::min_element(lanes.begin(), lanes.end(), [](const auto& a, const auto& b) {
+            return a.size() < b.size();
+        });
+        lane->insert(lane->end(), group.begin(), group.end());
+    }
+    
+    for (size_t w = 0; w < lanes.size(); w++) {
+        std::sort(lanes[w].begin(), lanes[w].end());
+        for (size_t rank : lanes[w]) {
+            deques.push(w, rank);
+        }
+    }
+}
+
+std::vector<ChainResult> scan_all(const std::string& address,
+                                   bool include_testnets,
+                                   bool only_with_activity,
+                                   size_t num_threads,
+                                   const QueryOptions& query) {
+    ScanOptions options;
+    options.include_testnets = include_testnets;
+    options.only_with_activity = only_with_activity;
+    options.num_threads = num_threads;
+    options.query = query;
+    return scan_all(address, options);
+}
+
+std::vector<ChainResult> scan_all(const std::string& address, const ScanOptions& options) {
+    Trace::Span scan_span("scan", "scan", address);
+    ScanState state;
+    std::vector<Chain> probed_chains;
+    auto valid_chains = select_chains(options, probed_chains);
+    
     size_t total_valid = valid_chains.size();
-    completed_count = 0;
     
-    // determine optimal worker count: min of requested threads and available chains
-    size_t actual_workers = std::min(num_threads, total_valid);
+    // determine optimal worker count: min of requested threads and available
+    // chains, bounded by the pool (plus the calling thread)
+    auto workers = pool();
+    size_t actual_workers = std::min({options.num_threads, total_valid, workers->size() + 1});
     if (actual_workers < 1) actual_workers = 1;
     
-    std::cout << "Scanning " << total_valid << " chains with " << actual_workers << " thread(s)...\n" << std::flush;
+    if (options.verbose) {
+        std::cout << "Scanning " << total_valid << " chains with " << actual_workers << " thread(s)...\n" << std::flush;
+    }
     
-    // Process chains in batches using thread pool
-    std::vector<std::thread> workers;
-    std::atomic<size_t> chain_index(0);
+    // Highest priority first. Ordered sinks scan in chain ID order so they do
+    // not hold back results waiting for low-priority chains; with top_k that
+    // is the k highest-priority chains, and the others are closed unscanned.
+    std::vector<size_t> order = ChainPriority::order(valid_chains);
+    size_t top_k = options.top_k > 0 ? std::min(options.top_k, total_valid) : total_valid;
+    std::vector<size_t> unscanned;
+    if (options.sink && options.sink->ordered()) {
+        unscanned.assign(order.begin() + top_k, order.end());
+        order.resize(top_k);
+        std::sort(order.begin(), order.end());
+    }
     
-    auto worker_func = [&]() {
-        while (true) {
-            size_t idx = chain_index.fetch_add(1);
-            if (idx >= valid_chains.size()) {
-                break;
+    // With top_k, stop handing out chains once the first k ranks are done
+    std::atomic<size_t> top_done(0);
+    std::atomic<bool> stop(top_k == 0);
+    std::atomic<size_t> skipped_top_k(unscanned.size());
+    
+    // Workers only touch their own result buffer and atomic counters; the
+    // reporter thread draws the progress line
+    state.results.resize(actual_workers);
+    std::optional<ProgressReporter> progress;
+    if (options.verbose) {
+        progress.emplace(std::cout, total_valid, isatty(STDOUT_FILENO) == 1);
+    }
+    
+    // Each pool worker owns a deque of chains grouped by endpoint host and
+    // steals from the others once its own runs dry. The calling thread has
+    // no deque: it always takes the lowest pending rank, so an ordered sink
+    // keeps advancing even before the pool starts this scan's workers.
+    // Thieves take the lowest rank too for an ordered sink: the highest would
+    // sit outside its reorder window and block instead of helping.
+    bool ordered = options.sink && options.sink->ordered();
+    WorkStealingDeques<size_t> deques(actual_workers > 1 ? actual_workers - 1 : 1, ordered);
+    assign_by_host(valid_chains, order, deques);
+    
+    auto worker_func = [&](size_t worker) {
+        while (!stop) {
+            bool stolen = false;
+            auto next = worker == 0 ? deques.pop_lowest() : deques.pop(worker - 1, &stolen);
+            if (!next) break;
+            size_t rank = *next;
+            size_t idx = order[rank];
+            const Chain& chain = *valid_chains[idx];
+            
+            if (progress) progress->started();
+            std::optional<ChainResult> result;
+            {
+                Trace::Span span("chain", "scan", chain.name, {chain.chain_id, static_cast<int>(worker), stolen});
+                result = process_chain(chain, address, state, options);
             }
             
-            auto& [original_idx, chain_ptr] = valid_chains[idx];
-            process_chain(*chain_ptr, address, results, only_with_activity);
+            if (options.sink) {
+                // An ordered sink may block here until earlier chains are in
+                Trace::Span span("emit", "sink", {}, {chain.chain_id});
+                options.sink->complete(idx, result ? &*result : nullptr);
+            } else if (result) {
+                state.results[worker].push_back(std::move(*result));
+            }
+            if (progress) progress->finished();
             
-            // Update progress
-            size_t done = completed_count.fetch_add(1) + 1;
-            {
-                std::lock_guard<std::mutex> lock(cout_mutex);
-                std::cout << "\rProgress: " << done << "/" << total_valid << " chains checked" << std::flush;
+            if (rank < top_k && top_done.fetch_add(1) + 1 == top_k) {
+                stop = true;
+                // Close what nobody will scan now, so no worker waits on it in the sink
+                while (auto left = deques.pop_lowest()) {
+                    if (options.sink) options.sink->skip(order[*left]);
+                    skipped_top_k++;
+                }
             }
         }
     };
     
-    // start workers
-    for (size_t i = 0; i < actual_workers; i++) {
-        workers.emplace_back(worker_func);
+    if (options.sink) {
+        options.sink->begin(address, total_valid);
+        for (size_t idx : unscanned) {
+            options.sink->skip(idx);
+        }
     }
     
+    // Run on the shared pool; the calling thread takes chains as well, so a
+    // scan still completes while other scans keep the pool busy
+    std::vector<std::future<void>> tasks;
+    for (size_t i = 1; i < actual_workers; i++) {
+        tasks.push_back(workers->submit([&worker_func, i] { worker_func(i); }));
+    }
+    worker_func(0);
+    
     // Wait for all workers to finish
-    for (auto& worker : workers) {
-        worker.join();
+    for (auto& task : tasks) {
+        task.get();
     }
     
-    std::cout << "\rProgress: " << total_valid << "/" << total_valid << " chains checked\n";
-    std::cout << "Scan complete.\n";
+    if (options.sink) {
+        options.sink->end();
+    }
     
-    // Sort results by chain_id
+    if (options.verbose) {
+        progress->stop();
+        if (skipped_top_k > 0) {
+            std::cout << "Stopped after the top " << top_k << " chain(s); " << skipped_top_k.load()
+                      << " left unscanned\n";
+        }
+        if (state.skipped_empty_count > 0) {
+            std::cout << "Skipped " << state.skipped_empty_count << " chain(s) known to be empty\n";
+        }
+        std::cout << "Scan complete.\n";
+    }
+    
+    // Merge the worker buffers and sort by chain_id
+    std::vector<ChainResult> results;
+    for (auto& buffer : state.results) {
+        std::move(buffer.begin(), buffer.end(), std::back_inserter(results));
+    }
     std::sort(results.begin(), results.end(), 
               [](const ChainResult& a, const ChainResult& b) {
                   return a.chain_id < b.chain_id;
@@ -195,7 +473,7 @@ void print_results(const std::vector<ChainResult>& results) {
                   << std::setw(8) << r.chain_id
                   << std::setw(20) << (r.chain_name.length() > 19 ? r.chain_name.substr(0, 16) + "..." : r.chain_name)
                   << std::setw(8) << r.symbol
-                  << std::setw(22) << (r.balance_eth + " " + r.symbol).substr(0, 21)
+                  << std::setw(22) << (r.balance.format_units(r.decimals) + " " + r.symbol).substr(0, 21)
                   << std::setw(10) << r.tx_count
                   << (r.explorer_url.empty() ? "-" : r.explorer_url)
                   << "\n";
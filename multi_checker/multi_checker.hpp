@@ -2,8 +2,17 @@
 #define MULTI_CHECKER_HPP
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
+#include "../rpc/rpc.hpp"
+#include "../cache/result_cache.hpp"
+#include "../cache/empty_filter.hpp"
+#include "../probe/endpoint_probe.hpp"
+#include "../chain/chain.hpp"
+
+class ResultSink;
+class WorkerPool;
 
 /**
  * Result of checking an address on a single chain
@@ -12,27 +21,120 @@ struct ChainResult {
     uint64_t chain_id;
     std::string chain_name;
     std::string symbol;
-    std::string balance_eth;
+    Uint256 balance;    // in the smallest unit (wei)
+    int decimals;       // native currency decimals, for display
     uint64_t tx_count;
-    bool is_contract;
+    bool is_contract;   // only known with QueryPlan::Proof
     bool has_activity;  // balance > 0 OR tx_count > 0
     std::string explorer_url;  // block explorer URL for the chain
+    uint64_t block_number;     // block the state was read at (0 if unknown)
+    bool from_cache;           // answered by the result cache
+};
+
+/**
+ * Options for a multi-chain scan
+ */
+struct ScanOptions {
+    bool include_testnets = false;
+    bool only_with_activity = true;     // only return chains with balance > 0 or tx_count > 0
+    size_t num_threads = 1;             // chains of this scan queried at once
+    QueryOptions query;                 // query plan used for every chain
+    uint64_t cache_ttl_blocks = ResultCache::DEFAULT_TTL_BLOCKS;  // cache freshness, in blocks
+    bool offline = false;               // answer from the result cache only, no network I/O
+    bool skip_empty = false;            // skip pairs the empty filter recorded as zero balance/nonce
+    double reverify_rate = 0.0;         // fraction of those pairs to query anyway (0..1)
+    bool probe_endpoints = false;       // probe all endpoints with eth_chainId before scanning
+    double probe_timeout = EndpointProbe::DEFAULT_TIMEOUT_SEC;  // per-endpoint probe timeout, in seconds
+    const std::vector<Chain>* chains = nullptr;  // chains to scan instead of the registry
+    bool verbose = true;                // print progress to stdout
+    ResultSink* sink = nullptr;         // receives results as chains complete instead of the returned vector
+    size_t top_k = 0;                   // stop once the k highest-priority chains are done (0: all)
 };
 
 namespace MultiChainChecker {
 
+constexpr size_t DEFAULT_WORKERS = 20;
+
+/**
+ * Start the worker pool shared by all scans
+ * Without a call, the pool is started with DEFAULT_WORKERS threads on
+ * first use. A scan uses at most num_threads of the workers at a time.
+ * @param workers Number of worker threads
+ * @return false if the pool was already running (its size is kept)
+ */
+bool init_pool(size_t workers);
+
+/**
+ * Worker pool shared by all scans, started on first use
+ * Holding the returned pointer keeps the pool alive across shutdown_pool().
+ */
+std::shared_ptr<WorkerPool> pool();
+
+/**
+ * Finish the queued tasks and stop the worker threads
+ * A later scan starts a new pool.
+ */
+void shutdown_pool();
+
 /**
  * Scan an address across all available chains
  * @param address Ethereum address to check
  * @param include_testnets If true, also scan testnet chains
  * @param only_with_activity If true, only return chains with balance > 0 or tx_count > 0
  * @param num_threads Number of concurrent threads to use (default: 1)
+ * @param query Query plan used for every chain
  * @return Vector of ChainResult for each chain checked
  */
 std::vector<ChainResult> scan_all(const std::string& address, 
                                    bool include_testnets = false,
                                    bool only_with_activity = true,
-                                   size_t num_threads = 1);
+                                   size_t num_threads = 1,
+                                   const QueryOptions& query = QueryOptions());
+
+/**
+ * Scan an address across all available chains
+ * Chains are queried in ChainPriority order (chain ID order for ordered
+ * sinks) and answered from the result cache first when it is open.
+ * Concurrent calls are safe; each keeps its own counters and results.
+ * @param address Ethereum address to check
+ * @param options Scan options
+ * @return Vector of ChainResult for each chain checked, sorted by chain ID
+ *         (empty when options.sink is set)
+ */
+std::vector<ChainResult> scan_all(const std::string& address, const ScanOptions& options);
+
+/**
+ * Chains a scan covers: testnet filter, HTTP endpoints, optional probe
+ * @param options Scan options
+ * @param probed Owns the pruned chain copies when options.probe_endpoints is set
+ * @return Chains in chain ID order
+ */
+std::vector<const Chain*> select_chains(const ScanOptions& options, std::vector<Chain>& probed);
+
+/**
+ * Answer a (chain, address) pair without network I/O
+ * Looks in the result cache, then in the empty filter (with skip_empty).
+ * @param known_empty Set when the answer came from the empty filter
+ * @return State of the pair, or nullopt if it has to be queried
+ */
+std::optional<AddressInfo> cached_info(const Chain& chain,
+                                       const std::string& address,
+                                       const ScanOptions& options,
+                                       bool& known_empty);
+
+/**
+ * Store a fresh answer in the result cache and empty filter
+ */
+void record_info(const Chain& chain, const std::string& address, const AddressInfo& info);
+
+/**
+ * Build the result of a pair
+ * @return nullopt when only_with_activity filters the pair out
+ */
+std::optional<ChainResult> make_result(const Chain& chain,
+                                       const AddressInfo& info,
+                                       bool from_cache,
+                                       const ScanOptions& options);
 
 /**
  * Print scan results in a formatted table
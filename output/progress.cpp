@@ -0,0 +1,67 @@
+#include "progress.hpp"
+#include <sstream>
+
+ProgressReporter::ProgressReporter(std::ostream& out, size_t total, bool tty)
+    : out_(out), total_(total), tty_(tty), start_(std::chrono::steady_clock::now()) {
+    thread_ = std::thread(&ProgressReporter::run, this);
+}
+
+ProgressReporter::~ProgressReporter() {
+    stop();
+}
+
+void ProgressReporter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    thread_.join();
+
+    std::string final_line = line(true);
+    if (tty_) {
+        // Pad over the remains of a longer in-place line
+        size_t pad = last_width_ > final_line.size() ? last_width_ - final_line.size() : 0;
+        out_ << "\r" << final_line << std::string(pad, ' ') << "\n" << std::flush;
+    } else {
+        out_ << final_line << "\n" << std::flush;
+    }
+}
+
+void ProgressReporter::run() {
+    auto interval = tty_ ? TTY_INTERVAL : LOG_INTERVAL;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!wake_.wait_for(lock, interval, [&] { return stopping_; })) {
+        std::string text = line(false);
+        if (tty_) {
+            size_t pad = last_width_ > text.size() ? last_width_ - text.size() : 0;
+            out_ << "\r" << text << std::string(pad, ' ') << std::flush;
+            last_width_ = text.size();
+        } else {
+            out_ << text << "\n" << std::flush;
+        }
+    }
+}
+
+std::string ProgressReporter::line(bool final) const {
+    size_t done = done_.load(std::memory_order_relaxed);
+    std::ostringstream ss;
+    ss << "Progress: " << done << "/" << total_ << " chains";
+    if (final) {
+        ss << " checked";
+        return ss.str();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    double rate = seconds > 0.0 ? done / seconds : 0.0;
+    ss.setf(std::ios::fixed);
+    ss.precision(1);
+    ss << ", " << rate << "/s, " << in_flight_.load(std::memory_order_relaxed) << " in flight";
+    if (rate > 0.0 && done < total_) {
+        ss << ", ETA " << static_cast<uint64_t>((total_ - done) / rate + 0.5) << "s";
+    }
+    return ss.str();
+}
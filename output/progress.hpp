@@ -0,0 +1,74 @@
+#ifndef PROGRESS_HPP
+#define PROGRESS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+/**
+ * Progress line of a scan, drawn by its own thread at a fixed rate
+ *
+ * Workers only bump atomic counters, so they never wait on each other or
+ * on the terminal. On a terminal the line is redrawn in place every
+ * TTY_INTERVAL; otherwise (pipes, log files) a plain line is written
+ * every LOG_INTERVAL, so logs do not fill up with carriage returns.
+ */
+class ProgressReporter {
+public:
+    static constexpr std::chrono::milliseconds TTY_INTERVAL{200};
+    static constexpr std::chrono::milliseconds LOG_INTERVAL{5000};
+
+    /**
+     * Start the reporter thread
+     * @param out Stream the progress goes to
+     * @param total Number of items the scan will complete
+     * @param tty Redraw in place (pass isatty() of the stream's descriptor)
+     */
+    ProgressReporter(std::ostream& out, size_t total, bool tty);
+    ~ProgressReporter();
+
+    ProgressReporter(const ProgressReporter&) = delete;
+    ProgressReporter& operator=(const ProgressReporter&) = delete;
+
+    /**
+     * An item was picked up by a worker
+     */
+    void started() { in_flight_.fetch_add(1, std::memory_order_relaxed); }
+
+    /**
+     * An item was completed
+     */
+    void finished() {
+        in_flight_.fetch_sub(1, std::memory_order_relaxed);
+        done_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Stop the thread and write the final line: "Progress: done/total chains checked"
+     */
+    void stop();
+
+private:
+    void run();
+    std::string line(bool final) const;
+
+    std::ostream& out_;
+    size_t total_;
+    bool tty_;
+    std::chrono::steady_clock::time_point start_;
+    std::atomic<size_t> done_{0};
+    std::atomic<size_t> in_flight_{0};
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    size_t last_width_ = 0;
+    std::thread thread_;
+};
+
+#endif // PROGRESS_HPP
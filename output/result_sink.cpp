@@ -0,0 +1,255 @@
+#include "result_sink.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+namespace {
+
+bool write_fd(int fd, const char* data, size_t len, bool is_socket) {
+    while (len > 0) {
+        // send() keeps a closed HTTP client from raising SIGPIPE
+        ssize_t n = is_socket ? send(fd, data, len, MSG_NOSIGNAL) : ::write(fd, data, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool fd_is_socket(int fd) {
+    struct stat st;
+    return fstat(fd, &st) == 0 && S_ISSOCK(st.st_mode);
+}
+
+std::string csv_field(const std::string& value) {
+    if (value.find_first_of(",\"\r\n") == std::string::npos) {
+        return value;
+    }
+
+    std::string out = "\"";
+    for (char c : value) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += '"';
+    return out;
+}
+
+} // anonymous namespace
+
+// BufferedWriter
+
+BufferedWriter::BufferedWriter(int fd, bool chunked, size_t capacity, std::chrono::milliseconds max_delay)
+    : fd_(fd), is_socket_(fd_is_socket(fd)), chunked_(chunked), capacity_(capacity), max_delay_(max_delay) {
+    buffer_.reserve(capacity_);
+}
+
+BufferedWriter::~BufferedWriter() {
+    flush();
+}
+
+bool BufferedWriter::write(const std::string& data) {
+    if (failed_) return false;
+
+    buffer_ += data;
+    if (buffer_.size() >= capacity_ ||
+        std::chrono::steady_clock::now() - last_flush_ >= max_delay_) {
+        return flush();
+    }
+    return true;
+}
+
+bool BufferedWriter::flush() {
+    last_flush_ = std::chrono::steady_clock::now();
+    if (failed_ || buffer_.empty()) {
+        return !failed_;
+    }
+
+    if (chunked_) {
+        char size[20];
+        int n = std::snprintf(size, sizeof(size), "%zx\r\n", buffer_.size());
+        buffer_ += "\r\n";
+        failed_ = !write_fd(fd_, size, static_cast<size_t>(n), is_socket_) ||
+                  !write_fd(fd_, buffer_.data(), buffer_.size(), is_socket_);
+    } else {
+        failed_ = !write_fd(fd_, buffer_.data(), buffer_.size(), is_socket_);
+    }
+    buffer_.clear();
+    return !failed_;
+}
+
+bool BufferedWriter::close() {
+    if (closed_) return !failed_;
+    closed_ = true;
+
+    flush();
+    if (chunked_ && !failed_) {
+        failed_ = !write_fd(fd_, "0\r\n\r\n", 5, is_socket_);
+    }
+    return !failed_;
+}
+
+// NdjsonSink
+
+void NdjsonSink::begin(const std::string& address, size_t chains) {
+    (void)chains;
+    std::lock_guard<std::mutex> lock(mutex_);
+    address_ = address;
+}
+
+void NdjsonSink::complete(size_t seq, const ChainResult* result) {
+    (void)seq;
+    if (!result) return;
+
+    std::string line = ResultFormat::json_line(*result, address_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    out_.write(line);
+    count_++;
+}
+
+void NdjsonSink::end() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out_.flush();
+}
+
+size_t NdjsonSink::count() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+}
+
+// CsvSink
+
+void CsvSink::begin(const std::string& address, size_t chains) {
+    (void)chains;
+    std::lock_guard<std::mutex> lock(mutex_);
+    address_ = address;
+    if (!header_written_) {
+        out_.write(ResultFormat::csv_header());
+        header_written_ = true;
+    }
+}
+
+void CsvSink::complete(size_t seq, const ChainResult* result) {
+    (void)seq;
+    if (!result) return;
+
+    std::string row = ResultFormat::csv_row(*result, address_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    out_.write(row);
+}
+
+void CsvSink::end() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out_.flush();
+}
+
+// OrderedSink
+
+OrderedSink::OrderedSink(ResultSink& inner, size_t window)
+    : inner_(inner), window_(window > 0 ? window : 1) {}
+
+void OrderedSink::begin(const std::string& address, size_t chains) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    next_ = 0;
+    pending_.clear();
+    inner_.begin(address, chains);
+}
+
+void OrderedSink::complete(size_t seq, const ChainResult* result) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // The worker holding chain next_ never waits, and scan_all skip()s the
+    // chains it will not scan, so this always drains
+    advanced_.wait(lock, [&] { return seq < next_ + window_; });
+
+    if (seq != next_) {
+        pending_.emplace(seq, result ? std::optional<ChainResult>(*result) : std::nullopt);
+        return;
+    }
+    advance_locked(seq, result);
+}
+
+void OrderedSink::skip(size_t seq) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (seq != next_) {
+        pending_.emplace(seq, std::nullopt);
+        return;
+    }
+    advance_locked(seq, nullptr);
+}
+
+void OrderedSink::advance_locked(size_t seq, const ChainResult* result) {
+    inner_.complete(seq, result);
+    next_++;
+    for (auto it = pending_.begin(); it != pending_.end() && it->first == next_; it = pending_.erase(it)) {
+        inner_.complete(it->first, it->second ? &*it->second : nullptr);
+        next_++;
+    }
+    advanced_.notify_all();
+}
+
+void OrderedSink::end() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    inner_.end();
+}
+
+// ResultFormat
+
+namespace ResultFormat {
+
+std::string json_line(const ChainResult& r, const std::string& address) {
+    json j;
+    if (!address.empty()) {
+        j["address"] = address;
+    }
+    j["chain_id"] = r.chain_id;
+    j["chain"] = r.chain_name;
+    j["symbol"] = r.symbol;
+    j["balance"] = r.balance.format_units(r.decimals);
+    j["balance_wei"] = r.balance.to_decimal();
+    j["tx_count"] = r.tx_count;
+    j["block"] = r.block_number;
+    j["is_contract"] = r.is_contract;
+    j["cached"] = r.from_cache;
+    j["explorer"] = r.explorer_url;
+    // Chain names from chainlist are not guaranteed to be valid UTF-8
+    return j.dump(-1, ' ', false, json::error_handler_t::replace) + "\n";
+}
+
+std::string csv_header() {
+    return "address,chain_id,chain,symbol,balance,balance_wei,tx_count,block,is_contract,cached,explorer\n";
+}
+
+std::string csv_row(const ChainResult& r, const std::string& address) {
+    std::string row;
+    row += address;
+    row += ',';
+    row += std::to_string(r.chain_id);
+    row += ',';
+    row += csv_field(r.chain_name);
+    row += ',';
+    row += csv_field(r.symbol);
+    row += ',';
+    row += r.balance.format_units(r.decimals);
+    row += ',';
+    row += r.balance.to_decimal();
+    row += ',';
+    row += std::to_string(r.tx_count);
+    row += ',';
+    row += std::to_string(r.block_number);
+    row += ',';
+    row += r.is_contract ? "true" : "false";
+    row += ',';
+    row += r.from_cache ? "true" : "false";
+    row += ',';
+    row += csv_field(r.explorer_url);
+    row += '\n';
+    return row;
+}
+
+} // namespace ResultFormat
@@ -0,0 +1,199 @@
+#ifndef RESULT_SINK_HPP
+#define RESULT_SINK_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include "../multi_checker/multi_checker.hpp"
+
+/**
+ * Receiver of scan results as chains complete
+ * scan_all numbers the chains of a scan 0..n-1 in chain ID order and
+ * calls complete() once per chain from the worker threads, in completion
+ * order. Implementations must be thread-safe.
+ */
+class ResultSink {
+public:
+    virtual ~ResultSink() = default;
+
+    /**
+     * Called before the first chain of a scan
+     * @param address Scanned address
+     * @param chains Number of chains that will be completed
+     */
+    virtual void begin(const std::string& address, size_t chains) { (void)address; (void)chains; }
+
+    /**
+     * Called once per chain
+     * @param seq Position of the chain in chain ID order
+     * @param result Result, or nullptr when the chain has nothing to report
+     */
+    virtual void complete(size_t seq, const ChainResult* result) = 0;
+
+    /**
+     * Close the slot of a chain that will not be scanned
+     * Unlike complete(), never waits for earlier chains.
+     * @param seq Position of the chain in chain ID order
+     */
+    virtual void skip(size_t seq) { complete(seq, nullptr); }
+
+    /**
+     * Called after the last chain of a scan
+     */
+    virtual void end() {}
+
+    /**
+     * Whether the sink emits results in seq order
+     * scan_all then queries chains in chain ID order instead of priority
+     * order, so the sink never waits long for the next chain. With top_k
+     * it picks the k highest-priority chains and skip()s the others.
+     */
+    virtual bool ordered() const { return false; }
+};
+
+/**
+ * Buffered writer to a file descriptor
+ * Data is flushed when the buffer fills up or when the last flush is
+ * older than max_delay, so a slow trickle of results still shows up
+ * promptly while a fast stream goes out in large writes. In chunked mode
+ * every flush is framed as an HTTP/1.1 chunk.
+ */
+class BufferedWriter {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+    static constexpr std::chrono::milliseconds DEFAULT_MAX_DELAY{100};
+
+    explicit BufferedWriter(int fd,
+                            bool chunked = false,
+                            size_t capacity = DEFAULT_CAPACITY,
+                            std::chrono::milliseconds max_delay = DEFAULT_MAX_DELAY);
+    ~BufferedWriter();
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    /**
+     * Append data, flushing if due
+     * @return false once the descriptor failed (the peer went away)
+     */
+    bool write(const std::string& data);
+
+    /**
+     * Write out buffered data
+     */
+    bool flush();
+
+    /**
+     * Flush and, in chunked mode, write the terminating chunk
+     */
+    bool close();
+
+private:
+    int fd_;
+    bool is_socket_;
+    bool chunked_;
+    bool closed_ = false;
+    bool failed_ = false;
+    size_t capacity_;
+    std::chrono::milliseconds max_delay_;
+    std::chrono::steady_clock::time_point last_flush_{};
+    std::string buffer_;
+};
+
+/**
+ * One JSON object per line for each chain with a result
+ */
+class NdjsonSink : public ResultSink {
+public:
+    explicit NdjsonSink(BufferedWriter& out) : out_(out) {}
+
+    void begin(const std::string& address, size_t chains) override;
+    void complete(size_t seq, const ChainResult* result) override;
+    void end() override;
+
+    /**
+     * Number of results written so far
+     */
+    size_t count();
+
+private:
+    BufferedWriter& out_;
+    std::mutex mutex_;
+    std::string address_;
+    size_t count_ = 0;
+};
+
+/**
+ * CSV rows with a header line before the first row
+ */
+class CsvSink : public ResultSink {
+public:
+    explicit CsvSink(BufferedWriter& out) : out_(out) {}
+
+    void begin(const std::string& address, size_t chains) override;
+    void complete(size_t seq, const ChainResult* result) override;
+    void end() override;
+
+private:
+    BufferedWriter& out_;
+    std::mutex mutex_;
+    std::string address_;
+    bool header_written_ = false;
+};
+
+/**
+ * Forwards results to another sink in chain ID order
+ * Out-of-order results wait in a reorder buffer. A worker whose chain is
+ * more than `window` positions ahead of the oldest unfinished chain
+ * blocks until that chain completes, so the buffer never holds more than
+ * `window` results no matter how large the scan is.
+ */
+class OrderedSink : public ResultSink {
+public:
+    static constexpr size_t DEFAULT_WINDOW = 256;
+
+    explicit OrderedSink(ResultSink& inner, size_t window = DEFAULT_WINDOW);
+
+    void begin(const std::string& address, size_t chains) override;
+    void complete(size_t seq, const ChainResult* result) override;
+    void skip(size_t seq) override;
+    void end() override;
+    bool ordered() const override { return true; }
+
+private:
+    // Emit chain next_ and every pending chain that follows it
+    void advance_locked(size_t seq, const ChainResult* result);
+
+    ResultSink& inner_;
+    size_t window_;
+    std::mutex mutex_;
+    std::condition_variable advanced_;
+    size_t next_ = 0;
+    std::map<size_t, std::optional<ChainResult>> pending_;
+};
+
+namespace ResultFormat {
+
+/**
+ * Format a result as a single-line JSON object (with trailing newline)
+ * @param address Scanned address, omitted when empty
+ */
+std::string json_line(const ChainResult& result, const std::string& address = "");
+
+/**
+ * CSV header matching csv_row
+ */
+std::string csv_header();
+
+/**
+ * Format a result as a CSV row (with trailing newline)
+ */
+std::string csv_row(const ChainResult& result, const std::string& address);
+
+} // namespace ResultFormat
+
+#endif // RESULT_SINK_HPP
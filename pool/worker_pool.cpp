@@ -0,0 +1,71 @@
+#include "worker_pool.hpp"
+#include "../trace/trace.hpp"
+#include <exception>
+#include <iostream>
+
+WorkerPool::WorkerPool(size_t workers) : size_(workers > 0 ? workers : 1) {
+    threads_.reserve(size_);
+    for (size_t i = 0; i < size_; i++) {
+        threads_.emplace_back(&WorkerPool::worker, this, i);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    shutdown();
+}
+
+bool WorkerPool::post(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return false;
+        }
+        tasks_.push_back(std::move(task));
+    }
+    task_ready_.notify_one();
+    return true;
+}
+
+void WorkerPool::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    task_ready_.notify_all();
+
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+size_t WorkerPool::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tasks_.size();
+}
+
+void WorkerPool::worker(size_t index) {
+    Trace::set_thread_name("pool " + std::to_string(index));
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            task_ready_.wait(lock, [&] { return stopping_ || !tasks_.empty(); });
+            // Queued tasks still run after shutdown() so no caller is left waiting
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+
+        try {
+            task();
+        } catch (const std::exception& e) {
+            std::cerr << "Warning: Worker task failed: " << e.what() << "\n";
+        } catch (...) {
+            std::cerr << "Warning: Worker task failed\n";
+        }
+    }
+}
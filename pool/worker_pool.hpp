@@ -0,0 +1,85 @@
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Fixed set of long-lived threads running submitted tasks in FIFO order
+ *
+ * Threads are started once and reused by every scan, so repeated scans
+ * (multi-address runs, the daemon, the HTTP server) do not pay for thread
+ * creation and teardown. A task must not block waiting for another task
+ * of the same pool, or a saturated pool deadlocks.
+ */
+class WorkerPool {
+public:
+    /**
+     * Start the worker threads
+     * @param workers Number of threads (at least 1)
+     */
+    explicit WorkerPool(size_t workers);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * Queue a task and get its result through a future
+     * Exceptions thrown by the task are rethrown by future::get().
+     * @throws std::runtime_error if the pool was shut down
+     */
+    template <typename F>
+    std::future<std::invoke_result_t<F>> submit(F&& fn) {
+        using R = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(fn));
+        std::future<R> result = task->get_future();
+        if (!post([task]() { (*task)(); })) {
+            throw std::runtime_error("worker pool is shut down");
+        }
+        return result;
+    }
+
+    /**
+     * Queue a task without a future; completion is up to the task itself
+     * (e.g. a callback it invokes). Exceptions are reported on stderr.
+     * @return false if the pool was shut down (the task is dropped)
+     */
+    bool post(std::function<void()> task);
+
+    /**
+     * Stop accepting tasks, run the ones already queued and join the threads
+     * Safe to call more than once.
+     */
+    void shutdown();
+
+    /**
+     * Number of worker threads
+     */
+    size_t size() const { return size_; }
+
+    /**
+     * Tasks queued but not yet started
+     */
+    size_t pending() const;
+
+private:
+    void worker(size_t index);
+
+    size_t size_;
+    mutable std::mutex mutex_;
+    std::condition_variable task_ready_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+};
+
+#endif // WORKER_POOL_HPP
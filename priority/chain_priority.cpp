@@ -0,0 +1,174 @@
+#include "chain_priority.hpp"
+#include "../include/json.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+
+using json = nlohmann::json;
+
+namespace ChainPriority {
+
+namespace {
+
+struct ChainStats {
+    uint64_t scans = 0;
+    uint64_t hits = 0;
+    double latency_ms = -1.0;   // moving average, negative until measured
+};
+
+constexpr double LATENCY_ALPHA = 0.2;  // weight of a new latency sample
+
+std::mutex stats_mutex;
+std::unordered_map<uint64_t, ChainStats> stats;
+std::unordered_map<uint64_t, double> weights;
+std::string history_path;
+
+double score_locked(const Chain& chain) {
+    double weight = 1.0;
+    auto w = weights.find(chain.chain_id);
+    if (w != weights.end()) {
+        weight = w->second;
+    }
+
+    double base_rate = chain.is_testnet ? TESTNET_BASE_RATE : MAINNET_BASE_RATE;
+    double scans = 0.0, hits = 0.0, latency_ms = DEFAULT_LATENCY_MS;
+    auto s = stats.find(chain.chain_id);
+    if (s != stats.end()) {
+        scans = static_cast<double>(s->second.scans);
+        hits = static_cast<double>(s->second.hits);
+        if (s->second.latency_ms >= 0.0) {
+            latency_ms = s->second.latency_ms;
+        }
+    }
+
+    double activity = (hits + PRIOR_WEIGHT * base_rate) / (scans + PRIOR_WEIGHT);
+    return weight * activity / (1.0 + latency_ms / 1000.0);
+}
+
+} // anonymous namespace
+
+bool load(const std::string& path) {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    history_path = path;
+
+    std::ifstream f(path);
+    if (!f) {
+        return true;
+    }
+
+    try {
+        json data = json::parse(f);
+        for (const auto& [key, entry] : data.items()) {
+            ChainStats& s = stats[std::stoull(key)];
+            s.scans = entry.value("scans", uint64_t{0});
+            s.hits = std::min(entry.value("hits", uint64_t{0}), s.scans);
+            s.latency_ms = entry.value("latency_ms", -1.0);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Warning: Ignoring " << path << ": " << e.what() << "\n";
+        stats.clear();
+        return false;
+    }
+    return true;
+}
+
+bool save() {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    if (history_path.empty()) {
+        return false;
+    }
+
+    json data = json::object();
+    for (const auto& [chain_id, s] : stats) {
+        json entry = {{"scans", s.scans}, {"hits", s.hits}};
+        if (s.latency_ms >= 0.0) {
+            entry["latency_ms"] = static_cast<int64_t>(s.latency_ms + 0.5);
+        }
+        data[std::to_string(chain_id)] = entry;
+    }
+
+    // Write a temporary file and rename it, so concurrent runs never see a
+    // partial file (the last writer wins)
+    std::string tmp = history_path + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::trunc);
+        if (!f) {
+            return false;
+        }
+        f << data.dump() << "\n";
+        if (!f) {
+            return false;
+        }
+    }
+    return std::rename(tmp.c_str(), history_path.c_str()) == 0;
+}
+
+bool parse_weights(const std::string& spec) {
+    size_t pos = 0;
+    while (pos < spec.size()) {
+        size_t end = spec.find(',', pos);
+        if (end == std::string::npos) end = spec.size();
+        std::string pair = spec.substr(pos, end - pos);
+        pos = end + 1;
+        if (pair.empty()) continue;
+
+        size_t eq = pair.find('=');
+        if (eq == std::string::npos) {
+            return false;
+        }
+        try {
+            uint64_t chain_id = std::stoull(pair.substr(0, eq));
+            double weight = std::stod(pair.substr(eq + 1));
+            if (weight < 0.0) {
+                return false;
+            }
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            weights[chain_id] = weight;
+        } catch (...) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void record(uint64_t chain_id, bool has_activity, double latency_ms) {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    ChainStats& s = stats[chain_id];
+    s.scans++;
+    if (has_activity) {
+        s.hits++;
+    }
+    if (latency_ms >= 0.0) {
+        s.latency_ms = s.latency_ms < 0.0 ? latency_ms
+                                          : s.latency_ms + LATENCY_ALPHA * (latency_ms - s.latency_ms);
+    }
+}
+
+double score(const Chain& chain) {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    return score_locked(chain);
+}
+
+std::vector<size_t> order(const std::vector<const Chain*>& chains) {
+    std::vector<double> scores(chains.size());
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        for (size_t i = 0; i < chains.size(); i++) {
+            scores[i] = score_locked(*chains[i]);
+        }
+    }
+
+    std::vector<size_t> positions(chains.size());
+    for (size_t i = 0; i < positions.size(); i++) {
+        positions[i] = i;
+    }
+    std::stable_sort(positions.begin(), positions.end(), [&](size_t a, size_t b) {
+        return scores[a] > scores[b];
+    });
+    return positions;
+}
+
+} // namespace ChainPriority
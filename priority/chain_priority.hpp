@@ -0,0 +1,70 @@
+#ifndef CHAIN_PRIORITY_HPP
+#define CHAIN_PRIORITY_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../chain/chain.hpp"
+
+/**
+ * Scan order of chains
+ *
+ * Each chain gets a score from a user weight (default 1), how often
+ * scans found activity on it (kept in data/priors.json across runs) and
+ * the measured latency of its endpoints:
+ *
+ *   score = weight * (hits + PRIOR_WEIGHT * base_rate) / (scans + PRIOR_WEIGHT)
+ *                  / (1 + latency_sec)
+ *
+ * base_rate is lower for testnets, so chains without history start with
+ * mainnets first. Chains are scanned highest score first.
+ */
+namespace ChainPriority {
+
+constexpr const char* DEFAULT_PATH = "data/priors.json";
+constexpr double PRIOR_WEIGHT = 2.0;          // pseudo-scans behind the base rate
+constexpr double MAINNET_BASE_RATE = 0.1;
+constexpr double TESTNET_BASE_RATE = 0.02;
+constexpr double DEFAULT_LATENCY_MS = 500.0;  // assumed until a chain was queried
+
+/**
+ * Load the activity history
+ * A missing file starts an empty history. Statistics are kept in memory
+ * either way; save() writes them back to this path.
+ * @param path History file path
+ * @return false if the file exists but could not be parsed
+ */
+bool load(const std::string& path = DEFAULT_PATH);
+
+/**
+ * Write the history to the loaded path (no-op before load())
+ * @return true if the file was written
+ */
+bool save();
+
+/**
+ * Parse user weights: comma-separated chain_id=weight pairs ("1=10,8453=5")
+ * @return false on a malformed pair (earlier pairs stay applied)
+ */
+bool parse_weights(const std::string& spec);
+
+/**
+ * Record the outcome of querying one chain
+ * @param has_activity Balance or nonce was non-zero
+ * @param latency_ms Request time, or a negative value if unknown
+ */
+void record(uint64_t chain_id, bool has_activity, double latency_ms);
+
+/**
+ * Priority score of a chain (higher scans first)
+ */
+double score(const Chain& chain);
+
+/**
+ * Positions of the chains, highest score first (ties by position)
+ */
+std::vector<size_t> order(const std::vector<const Chain*>& chains);
+
+} // namespace ChainPriority
+
+#endif // CHAIN_PRIORITY_HPP
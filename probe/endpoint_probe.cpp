@@ -0,0 +1,201 @@
+#include "endpoint_probe.hpp"
+#include "../rpc/rpc.hpp"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+namespace {
+
+// Quote a value for a curl config file
+std::string config_quote(const std::string& value) {
+    std::string out = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    out += '"';
+    return out;
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream f(path, std::ios::binary);
+    std::ostringstream ss;
+    ss << f.rdbuf();
+    return ss.str();
+}
+
+// chain ID from an eth_chainId response body, 0 if invalid
+uint64_t parse_chain_id(const std::string& body) {
+    try {
+        json r = json::parse(body);
+        if (r.is_object() && r.contains("result") && r["result"].is_string()) {
+            return RpcClient::hex_to_uint64(r["result"].get_ref<const std::string&>());
+        }
+    } catch (...) {
+        // Parked domains answer with HTML
+    }
+    return 0;
+}
+
+} // anonymous namespace
+
+namespace EndpointProbe {
+
+bool is_http_endpoint(const std::string& rpc_url) {
+    return rpc_url.find("http") == 0 &&
+           rpc_url.find("${") == std::string::npos &&
+           rpc_url.find("{") == std::string::npos;
+}
+
+std::string endpoint_host(const std::string& rpc_url) {
+    size_t start = rpc_url.find("://");
+    start = start == std::string::npos ? 0 : start + 3;
+    size_t end = rpc_url.find_first_of("/?#", start);
+    std::string authority = rpc_url.substr(start, end == std::string::npos ? std::string::npos : end - start);
+
+    size_t at = authority.rfind('@');
+    if (at != std::string::npos) {
+        authority.erase(0, at + 1);
+    }
+    size_t colon = authority.rfind(':');
+    if (colon != std::string::npos && authority.find(']') == std::string::npos) {
+        authority.erase(colon);
+    }
+
+    std::transform(authority.begin(), authority.end(), authority.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return authority;
+}
+
+std::vector<EndpointHealth> probe(const std::vector<const Chain*>& chains,
+                                  double timeout_sec,
+                                  size_t parallel) {
+    std::vector<EndpointHealth> health;
+    for (const Chain* chain : chains) {
+        for (const auto& url : chain->rpc_urls) {
+            if (is_http_endpoint(url)) {
+                health.push_back({url, chain->chain_id, 0, 0.0, false});
+            }
+        }
+    }
+
+    if (health.empty()) {
+        return health;
+    }
+
+    char dir_template[] = "/tmp/checker-probe-XXXXXX";
+    if (!mkdtemp(dir_template)) {
+        return health;
+    }
+    std::string dir = dir_template;
+
+    // One url/output pair per endpoint; bodies land in dir/<index>
+    std::string config_path = dir + "/config";
+    {
+        std::ofstream config(config_path);
+        for (size_t i = 0; i < health.size(); i++) {
+            config << "url = " << config_quote(health[i].url) << "\n"
+                   << "output = " << config_quote(dir + "/" + std::to_string(i)) << "\n";
+        }
+    }
+
+    if (parallel < 1) parallel = 1;
+    if (parallel > 300) parallel = 300;  // curl's limit
+
+    std::ostringstream cmd;
+    cmd << "curl -s -Z --parallel-max " << parallel
+        << " --max-time " << timeout_sec << " --connect-timeout " << timeout_sec
+        << " -X POST -H 'Content-Type: application/json'"
+        << " -d '{\"jsonrpc\":\"2.0\",\"method\":\"eth_chainId\",\"params\":[],\"id\":1}'"
+        << " -K '" << config_path << "'"
+        << " -w '%{urlnum} %{http_code} %{time_total}\\n' 2>/dev/null";
+
+    // Transfer stats arrive in completion order, tagged with the URL index
+    auto pipe_deleter = [](FILE* f) { if (f) pclose(f); };
+    std::unique_ptr<FILE, decltype(pipe_deleter)> pipe(popen(cmd.str().c_str(), "r"), pipe_deleter);
+    if (pipe) {
+        std::array<char, 256> line;
+        while (fgets(line.data(), line.size(), pipe.get()) != nullptr) {
+            size_t index = 0;
+            int http_code = 0;
+            double time_total = 0.0;
+            if (std::sscanf(line.data(), "%zu %d %lf", &index, &http_code, &time_total) != 3) continue;
+            if (index >= health.size()) continue;
+
+            auto& h = health[index];
+            h.latency_ms = time_total * 1000.0;
+            if (http_code == 200) {
+                h.reported_chain_id = parse_chain_id(read_file(dir + "/" + std::to_string(index)));
+                h.alive = h.reported_chain_id == h.expected_chain_id;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < health.size(); i++) {
+        unlink((dir + "/" + std::to_string(i)).c_str());
+    }
+    unlink(config_path.c_str());
+    rmdir(dir.c_str());
+
+    return health;
+}
+
+std::vector<Chain> prune(const std::vector<const Chain*>& chains,
+                         ProbeSummary* summary,
+                         double timeout_sec) {
+    auto health = probe(chains, timeout_sec);
+
+    ProbeSummary totals{};
+    totals.endpoints = health.size();
+
+    // probe() lists endpoints chain by chain, in rpc_urls order
+    std::vector<Chain> pruned;
+    size_t next = 0;
+    for (const Chain* chain : chains) {
+        std::vector<const EndpointHealth*> live;
+        for (const auto& url : chain->rpc_urls) {
+            if (!is_http_endpoint(url)) continue;
+
+            const auto& h = health[next++];
+            if (h.alive) {
+                totals.alive++;
+                live.push_back(&h);
+            } else if (h.reported_chain_id != 0) {
+                totals.wrong_chain++;
+            } else {
+                totals.dead++;
+            }
+        }
+
+        if (live.empty()) {
+            totals.chains_lost++;
+            continue;
+        }
+
+        std::stable_sort(live.begin(), live.end(), [](const EndpointHealth* a, const EndpointHealth* b) {
+            return a->latency_ms < b->latency_ms;
+        });
+
+        Chain copy = *chain;
+        copy.rpc_urls.clear();
+        for (const auto* h : live) {
+            copy.rpc_urls.push_back(h->url);
+        }
+        pruned.push_back(std::move(copy));
+    }
+
+    if (summary) {
+        *summary = totals;
+    }
+    return pruned;
+}
+
+} // namespace EndpointProbe
@@ -0,0 +1,74 @@
+#ifndef ENDPOINT_PROBE_HPP
+#define ENDPOINT_PROBE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../chain/chain.hpp"
+
+/**
+ * Outcome of probing a single endpoint
+ */
+struct EndpointHealth {
+    std::string url;
+    uint64_t expected_chain_id;
+    uint64_t reported_chain_id;  // 0 if the endpoint did not answer eth_chainId
+    double latency_ms;           // full request time
+    bool alive;                  // answered eth_chainId with the expected chain ID
+};
+
+/**
+ * Totals of a probe run
+ */
+struct ProbeSummary {
+    size_t endpoints;     // endpoints probed
+    size_t alive;         // answered with the expected chain ID
+    size_t wrong_chain;   // answered with another chain ID
+    size_t dead;          // no valid answer before the timeout
+    size_t chains_lost;   // chains left without any live endpoint
+};
+
+namespace EndpointProbe {
+
+constexpr double DEFAULT_TIMEOUT_SEC = 2.0;
+constexpr size_t DEFAULT_PARALLEL = 200;
+
+/**
+ * Check if an RPC URL is usable by the HTTP transport
+ */
+bool is_http_endpoint(const std::string& rpc_url);
+
+/**
+ * Host part of an endpoint URL, lowercase and without port or credentials
+ * e.g. "https://rpc.ankr.com/eth" -> "rpc.ankr.com"
+ */
+std::string endpoint_host(const std::string& rpc_url);
+
+/**
+ * Send eth_chainId to every HTTP endpoint of the given chains at once
+ * All requests go through one curl process with --parallel, so the probe
+ * takes about one timeout regardless of the number of endpoints.
+ * @param chains Chains whose endpoints are probed
+ * @param timeout_sec Per-request timeout
+ * @param parallel Maximum concurrent transfers
+ * @return One entry per probed endpoint
+ */
+std::vector<EndpointHealth> probe(const std::vector<const Chain*>& chains,
+                                  double timeout_sec = DEFAULT_TIMEOUT_SEC,
+                                  size_t parallel = DEFAULT_PARALLEL);
+
+/**
+ * Probe endpoints and keep only the live ones
+ * @param chains Chains to probe
+ * @param summary Filled with totals of the run (optional)
+ * @param timeout_sec Per-request timeout
+ * @return Copies of the chains that kept at least one endpoint, with
+ *         rpc_urls reduced to live endpoints, fastest first
+ */
+std::vector<Chain> prune(const std::vector<const Chain*>& chains,
+                         ProbeSummary* summary = nullptr,
+                         double timeout_sec = DEFAULT_TIMEOUT_SEC);
+
+} // namespace EndpointProbe
+
+#endif // ENDPOINT_PROBE_HPP
@@ -1,24 +1,63 @@
 #include "rpc.hpp"
 #include "../include/json.hpp"
+#include "../limiter/aimd_limiter.hpp"
+#include "../metrics/metrics.hpp"
+#include "../trace/trace.hpp"
+#include "../cassette/cassette.hpp"
+#include "../probe/endpoint_probe.hpp"
+
+extern "C" {
+#include "../hex/hex.h"
+}
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <sstream>
 #include <iomanip>
 #include <cmath>
 #include <array>
 #include <memory>
 #include <iostream>
+#include <mutex>
+#include <unordered_set>
+#include <sys/wait.h>
 
 using json = nlohmann::json;
 
+// keccak256 of empty bytecode - the codeHash of every EOA
+static const uint8_t EMPTY_CODE_HASH[32] = {
+    0xc5, 0xd2, 0x46, 0x01, 0x86, 0xf7, 0x23, 0x3c, 0x92, 0x7e, 0x7d, 0xb2, 0xdc, 0xc7, 0x03, 0xc0,
+    0xe5, 0x00, 0xb6, 0x53, 0xca, 0x82, 0x27, 0x3b, 0x7b, 0xfa, 0xd8, 0x04, 0x5d, 0x85, 0xa4, 0x70
+};
+
+// curl exit code for --max-time expiring
+static constexpr int CURL_TIMEOUT = 28;
+
+// Retries of a rate-limited request under adaptive concurrency
+static constexpr int RATE_LIMIT_RETRIES = 2;
+
+// Endpoints that answered eth_getProof with "method not supported"
+static std::mutex proof_mutex;
+static std::unordered_set<std::string> no_proof_endpoints;
+
+// JSON-RPC method not found; some nodes use invalid request/params with a message instead
+static constexpr int RPC_METHOD_NOT_FOUND = -32601;
+static constexpr int RPC_INVALID_REQUEST = -32600;
+static constexpr int RPC_INVALID_PARAMS = -32602;
 
 // Execute curl command and return output
-static std::string exec_curl(const std::string& cmd) {
+static std::string exec_curl(const std::string& cmd, int* exit_code = nullptr) {
     std::array<char, 4096> buffer;
     std::string result;
     
     auto pipe_deleter = [](FILE* f) { if (f) pclose(f); };
     std::unique_ptr<FILE, decltype(pipe_deleter)> pipe(popen(cmd.c_str(), "r"), pipe_deleter);
     if (!pipe) {
+        if (exit_code) *exit_code = -1;
         return "";
     }
     
@@ -26,22 +65,175 @@ static std::string exec_curl(const std::string& cmd) {
         result += buffer.data();
     }
     
+    int status = pclose(pipe.release());
+    if (exit_code) *exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    
     return result;
 }
 
-// Convert hex string to uint64_t
-static uint64_t hex_to_uint64(const std::string& hex) {
-    if (hex.empty()) return 0;
+// View a string result without copying it (empty if not a string)
+static std::string_view string_of(const json& j) {
+    return j.is_string() ? std::string_view(j.get_ref<const std::string&>()) : std::string_view();
+}
+
+// Run a curl command built by post_json and split its -w trailer off the body
+static HttpExchange curl_exchange(const std::string& cmd) {
+    HttpExchange exchange;
+    auto start = std::chrono::steady_clock::now();
+    std::string response = exec_curl(cmd, &exchange.exit_code);
+    exchange.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    
+    unsigned long long size_upload = 0, size_download = 0;
+    size_t status_line = response.rfind('\n');
+    const char* stats = status_line != std::string::npos ? response.c_str() + status_line + 1 : response.c_str();
+    std::sscanf(stats, "%d %lf %lf %lf %lf %lf %lf %llu %llu", &exchange.http_code, &exchange.namelookup,
+                &exchange.connect, &exchange.appconnect, &exchange.pretransfer, &exchange.starttransfer,
+                &exchange.total, &size_upload, &size_download);
+    exchange.bytes_sent = size_upload;
+    exchange.bytes_received = size_download;
+    if (status_line != std::string::npos) {
+        response.erase(status_line);
+        exchange.response = std::move(response);
+    }
+    return exchange;
+}
+
+// Check if a JSON-RPC error says the method is unavailable, as opposed to a
+// rate limit or a temporary upstream failure
+static bool method_unsupported(const json& error) {
+    if (!error.is_object() || !error.contains("code") || !error["code"].is_number_integer()) {
+        return false;
+    }
+    int code = error["code"].get<int>();
+    if (code == RPC_METHOD_NOT_FOUND) {
+        return true;
+    }
+    if (code != RPC_INVALID_REQUEST && code != RPC_INVALID_PARAMS) {
+        return false;
+    }
     
-    std::string h = hex;
-    if (h.substr(0, 2) == "0x" || h.substr(0, 2) == "0X") {
-        h = h.substr(2);
+    std::string message(string_of(error.contains("message") ? error["message"] : json()));
+    std::transform(message.begin(), message.end(), message.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    for (const char* phrase : {"not available", "not supported", "unsupported", "does not exist", "not found"}) {
+        if (message.find(phrase) != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// POST a JSON body to an RPC endpoint and return the raw response
+static std::string post_json(const std::string& rpc_url, const std::string& json_str) {
+    // Use single quotes for shell - safer and simpler
+    // Fast timeout for bulk scanning; the HTTP status and transfer timers are appended after the body
+    std::string cmd = "curl -s --max-time 5 --connect-timeout 3 -X POST "
+                      "-H 'Content-Type: application/json' "
+                      "-w '\\n%{http_code} %{time_namelookup} %{time_connect} %{time_appconnect} "
+                      "%{time_pretransfer} %{time_starttransfer} %{time_total} %{size_upload} %{size_download}' "
+                      "-d '" + json_str + "' '" + rpc_url + "' 2>/dev/null";
+    bool need_host = ConcurrencyControl::enabled() || Trace::enabled();
+    std::string host = need_host ? EndpointProbe::endpoint_host(rpc_url) : "";
+    bool replaying = Cassette::replaying();
+    
+    for (int attempt = 0; ; attempt++) {
+        // With -t auto, wait for the adaptive limits of the host and overall
+        uint64_t wait_start = Trace::enabled() ? Trace::now_us() : 0;
+        ConcurrencyControl::Permit permit(host);
+        uint64_t trace_start = Trace::enabled() ? Trace::now_us() : 0;
+        if (ConcurrencyControl::enabled()) {
+            Trace::record("permit", "limiter", wait_start, trace_start - wait_start, host);
+        }
+        
+        // With --replay the exchange comes from the cassette instead of the network
+        HttpExchange exchange = replaying ? Cassette::replay(rpc_url, json_str) : curl_exchange(cmd);
+        Cassette::record(rpc_url, json_str, exchange);
+        const int exit_code = exchange.exit_code;
+        const int http_code = exchange.http_code;
+        const double namelookup = exchange.namelookup, connect = exchange.connect;
+        const double appconnect = exchange.appconnect, pretransfer = exchange.pretransfer;
+        const double starttransfer = exchange.starttransfer, total = exchange.total;
+        
+        RequestOutcome outcome = RequestOutcome::Failed;
+        if (exit_code == CURL_TIMEOUT) {
+            outcome = RequestOutcome::Timeout;
+        } else if (http_code == 429 || http_code == 503) {
+            outcome = RequestOutcome::RateLimited;
+        } else if (http_code == 200) {
+            outcome = RequestOutcome::Ok;
+        }
+        permit.finish(outcome, exchange.elapsed_ms);
+        
+        if (Metrics::enabled()) {
+            FailureClass failure = FailureClass::None;
+            if (outcome == RequestOutcome::Timeout) {
+                failure = FailureClass::Timeout;
+            } else if (outcome == RequestOutcome::RateLimited) {
+                failure = FailureClass::RateLimited;
+            } else if (http_code == 0) {
+                failure = FailureClass::Transport;
+            } else if (http_code != 200) {
+                failure = FailureClass::Http;
+            }
+            
+            // curl's timers are cumulative from the start of the transfer
+            RequestTiming timing;
+            timing.dns = namelookup;
+            timing.connect = std::max(0.0, connect - namelookup);
+            timing.tls = appconnect > 0.0 ? std::max(0.0, appconnect - connect) : 0.0;
+            timing.ttfb = std::max(0.0, starttransfer - pretransfer);
+            timing.transfer = std::max(0.0, total - starttransfer);
+            timing.total = total > 0.0 ? total : exchange.elapsed_ms / 1000.0;
+            timing.bytes_sent = exchange.bytes_sent;
+            timing.bytes_received = exchange.bytes_received;
+            Metrics::record_request(rpc_url, timing, failure);
+        }
+        
+        if (Trace::enabled()) {
+            // curl's timers are offsets from the start of the transfer
+            auto at = [trace_start](double seconds) { return trace_start + static_cast<uint64_t>(seconds * 1e6); };
+            auto span = [&](const char* name, double from, double to) {
+                if (to > from) Trace::record(name, "request", at(from), at(to) - at(from), host);
+            };
+            uint64_t trace_end = Trace::now_us();
+            Trace::record("request", "request", trace_start, trace_end - trace_start, host);
+            span("dns", 0.0, namelookup);
+            span("connect", namelookup, connect);
+            if (appconnect > 0.0) span("tls", connect, appconnect);
+            span("ttfb", pretransfer, starttransfer);
+            span("transfer", starttransfer, total);
+        }
+        
+        // The host limit was just cut, so a retry waits for a smaller window
+        if (outcome == RequestOutcome::RateLimited && ConcurrencyControl::enabled() &&
+            attempt < RATE_LIMIT_RETRIES) {
+            Metrics::record_retry("rate_limit");
+            continue;
+        }
+        return std::move(exchange.response);
+    }
+}
+
+// Parse a response body, timing it for the metrics; throws like json::parse
+static json parse_response(const std::string& rpc_url, const std::string& response,
+                           json::parser_callback_t callback = nullptr) {
+    Trace::Span span("parse", "request");
+    if (!Metrics::enabled()) {
+        return json::parse(response, callback);
     }
     
+    auto start = std::chrono::steady_clock::now();
+    auto seconds = [&start]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
     try {
-        return std::stoull(h, nullptr, 16);
+        json parsed = json::parse(response, callback);
+        Metrics::record_parse(rpc_url, seconds(), true);
+        return parsed;
     } catch (...) {
-        return 0;
+        Metrics::record_parse(rpc_url, seconds(), false);
+        throw;
     }
 }
 
@@ -58,22 +250,14 @@ std::optional<json> json_rpc_call(const std::string& rpc_url,
         {"id", 1}
     };
     
-    std::string json_str = request.dump();
-    
-    // Use single quotes for shell - safer and simpler
-    // Fast timeout for bulk scanning
-    std::string cmd = "curl -s --max-time 5 --connect-timeout 3 -X POST "
-                      "-H 'Content-Type: application/json' "
-                      "-d '" + json_str + "' '" + rpc_url + "' 2>/dev/null";
-    
-    std::string response = exec_curl(cmd);
+    std::string response = post_json(rpc_url, request.dump());
     
     if (response.empty()) {
         return std::nullopt;
     }
     
     try {
-        json result = json::parse(response);
+        json result = parse_response(rpc_url, response);
         if (result.contains("result")) {
             return result["result"];
         }
@@ -88,6 +272,57 @@ std::optional<json> json_rpc_call(const std::string& rpc_url,
 
 namespace RpcClient {
 
+uint64_t hex_to_uint64(std::string_view hex) {
+    uint64_t value = 0;
+    if (!hex_decode_quantity(hex.data(), hex.size(), &value, 1)) {
+        return 0;
+    }
+    return value;
+}
+
+std::vector<std::optional<json>> batch_call(const std::string& rpc_url,
+                                            const std::vector<RpcCall>& calls) {
+    if (calls.empty()) {
+        return {};
+    }
+    
+    json batch = json::array();
+    for (size_t i = 0; i < calls.size(); i++) {
+        batch.push_back({{"jsonrpc", "2.0"}, {"method", calls[i].method}, {"params", calls[i].params}, {"id", i + 1}});
+    }
+    
+    std::string response = post_json(rpc_url, batch.dump());
+    
+    if (response.empty()) {
+        return {};
+    }
+    
+    std::vector<std::optional<json>> out(calls.size());
+    
+    try {
+        json results = parse_response(rpc_url, response);
+        
+        // A single object means the whole batch was rejected
+        if (!results.is_array()) {
+            return {};
+        }
+        
+        // Responses may arrive in any order - match them by id
+        for (auto& r : results) {
+            if (!r.contains("result") || !r.contains("id") || !r["id"].is_number_unsigned()) continue;
+            
+            size_t id = r["id"].get<size_t>();
+            if (id >= 1 && id <= calls.size()) {
+                out[id - 1] = std::move(r["result"]);
+            }
+        }
+    } catch (...) {
+        return {};
+    }
+    
+    return out;
+}
+
 std::optional<std::string> get_balance(const std::string& rpc_url, const std::string& address) {
     json params = json::array({address, "latest"});
     auto result = json_rpc_call(rpc_url, "eth_getBalance", params);
@@ -104,7 +339,7 @@ std::optional<uint64_t> get_transaction_count(const std::string& rpc_url, const
     auto result = json_rpc_call(rpc_url, "eth_getTransactionCount", params);
     
     if (result && result->is_string()) {
-        return hex_to_uint64(result->get<std::string>());
+        return hex_to_uint64(string_of(*result));
     }
     
     return std::nullopt;
@@ -172,97 +407,41 @@ bool is_contract(const std::string& rpc_url, const std::string& address) {
     auto result = json_rpc_call(rpc_url, "eth_getCode", params);
     
     if (result && result->is_string()) {
-        std::string code = result->get<std::string>();
         // If code is "0x" or empty, it's not a contract (EOA)
-        return code.length() > 2;
+        return string_of(*result).length() > 2;
     }
     
     return false;
 }
 
-std::string wei_to_eth(const std::string& wei_hex) {
-    if (wei_hex.empty() || wei_hex == "0x0") {
+std::string wei_to_eth(const std::string& wei_hex, int decimals) {
+    auto value = Uint256::from_hex(wei_hex);
+    if (!value) {
         return "0";
     }
     
-    std::string hex = wei_hex;
-    if (hex.substr(0, 2) == "0x" || hex.substr(0, 2) == "0X") {
-        hex = hex.substr(2);
-    }
-    
-    // Convert hex to decimal string (simple method for display)
-    // For large numbers, we do integer division
-    __uint128_t value = 0;
-    for (char c : hex) {
-        value *= 16;
-        if (c >= '0' && c <= '9') value += c - '0';
-        else if (c >= 'a' && c <= 'f') value += c - 'a' + 10;
-        else if (c >= 'A' && c <= 'F') value += c - 'A' + 10;
-    }
-    
-    // Convert to ETH (divide by 10^18)
-    constexpr __uint128_t ETH_DECIMALS = 1000000000000000000ULL;  // 10^18
-    
-    __uint128_t whole = value / ETH_DECIMALS;
-    __uint128_t fraction = value % ETH_DECIMALS;
-    
-    // Convert whole part to string
-    std::string whole_str;
-    if (whole == 0) {
-        whole_str = "0";
-    } else {
-        while (whole > 0) {
-            whole_str = char('0' + (whole % 10)) + whole_str;
-            whole /= 10;
-        }
-    }
-    
-    // Convert fraction part to string (with leading zeros)
-    std::string frac_str;
-    for (int i = 0; i < 18; i++) {
-        frac_str = char('0' + (fraction % 10)) + frac_str;
-        fraction /= 10;
-    }
-    
-    // Trim trailing zeros from fraction
-    while (frac_str.length() > 1 && frac_str.back() == '0') {
-        frac_str.pop_back();
-    }
-    
-    if (frac_str == "0") {
-        return whole_str;
-    }
-    
-    return whole_str + "." + frac_str;
+    return value->format_units(decimals);
 }
 
-AddressInfo check_address(const std::string& rpc_url, const std::string& address) {
+static AddressInfo check_address_batch(const std::string& rpc_url, const std::string& address) {
     AddressInfo info;
-    info.tx_count = 0;
-    info.has_token_activity = false;
-    info.is_contract = false;
-    info.balance_wei = "";
-    info.balance_eth = "";
     
-    // Batch RPC - send both requests in one HTTP call for speed
+    // Batch RPC - send all requests in one HTTP call for speed
+    // eth_blockNumber pins the block the state was read at
     json batch = json::array({
         {{"jsonrpc", "2.0"}, {"method", "eth_getBalance"}, {"params", json::array({address, "latest"})}, {"id", 1}},
-        {{"jsonrpc", "2.0"}, {"method", "eth_getTransactionCount"}, {"params", json::array({address, "latest"})}, {"id", 2}}
+        {{"jsonrpc", "2.0"}, {"method", "eth_getTransactionCount"}, {"params", json::array({address, "latest"})}, {"id", 2}},
+        {{"jsonrpc", "2.0"}, {"method", "eth_blockNumber"}, {"params", json::array()}, {"id", 3}}
     });
     
-    std::string json_str = batch.dump();
-    std::string cmd = "curl -s --max-time 5 --connect-timeout 3 -X POST "
-                      "-H 'Content-Type: application/json' "
-                      "-d '" + json_str + "' '" + rpc_url + "' 2>/dev/null";
-    
-    std::string response = exec_curl(cmd);
+    std::string response = post_json(rpc_url, batch.dump());
     
     if (response.empty()) {
         return info;
     }
     
     try {
-        json results = json::parse(response);
+        json results = parse_response(rpc_url, response);
         
         // Handle both array (batch response) and object (single error)
         if (!results.is_array()) {
@@ -273,17 +452,110 @@ AddressInfo check_address(const std::string& rpc_url, const std::string& address
             if (!r.contains("result") || !r.contains("id")) continue;
             
             int id = r["id"].get<int>();
-            std::string result_str = r["result"].get<std::string>();
+            std::string_view result_str = string_of(r["result"]);
             
             if (id == 1) {
                 // eth_getBalance
-                info.balance_wei = result_str;
-                info.balance_eth = wei_to_eth(result_str);
+                auto balance = Uint256::from_hex(result_str);
+                if (balance) {
+                    info.balance = *balance;
+                    info.ok = true;
+                }
             } else if (id == 2) {
                 // eth_getTransactionCount  
                 info.tx_count = hex_to_uint64(result_str);
+            } else if (id == 3) {
+                // eth_blockNumber
+                info.block_number = hex_to_uint64(result_str);
+            }
+        }
+    } catch (...) {
+        // Parse error
+    }
+    
+    return info;
+}
+
+// eth_getProof (+ eth_blockNumber) in one request - fills balance, nonce and codeHash
+// Returns nullopt if the endpoint rejected the method
+static std::optional<AddressInfo> check_address_proof(const std::string& rpc_url,
+                                                      const std::string& address,
+                                                      bool keep_proof) {
+    AddressInfo info;
+    
+    json batch = json::array({
+        {{"jsonrpc", "2.0"}, {"method", "eth_getProof"}, {"params", json::array({address, json::array(), "latest"})}, {"id", 1}},
+        {{"jsonrpc", "2.0"}, {"method", "eth_blockNumber"}, {"params", json::array()}, {"id", 2}}
+    });
+    
+    std::string response = post_json(rpc_url, batch.dump());
+    
+    if (response.empty()) {
+        return info;  // transport failure, not a verdict on eth_getProof
+    }
+    
+    // Proof nodes are ~10 x 500 bytes of hex - skip them while parsing unless asked for
+    json::parser_callback_t drop_proof = [keep_proof](int, json::parse_event_t event, json& parsed) {
+        if (keep_proof || event != json::parse_event_t::key) return true;
+        return parsed != "accountProof" && parsed != "storageProof";
+    };
+    
+    try {
+        json results = parse_response(rpc_url, response, drop_proof);
+        if (!results.is_array()) {
+            return info;
+        }
+        
+        const json* proof = nullptr;
+        for (const auto& r : results) {
+            if (!r.contains("id") || !r["id"].is_number()) continue;
+            
+            int id = r["id"].get<int>();
+            if (id == 1) {
+                proof = &r;
+            } else if (id == 2 && r.contains("result")) {
+                info.block_number = hex_to_uint64(string_of(r["result"]));
             }
         }
+        
+        if (!proof || !proof->contains("result") || !(*proof)["result"].is_object()) {
+            if (proof && proof->contains("error")) {
+                // Only a missing method disables eth_getProof for the endpoint; any
+                // other error just sends this query through the plain batch
+                if (method_unsupported((*proof)["error"])) {
+                    std::lock_guard<std::mutex> lock(proof_mutex);
+                    no_proof_endpoints.insert(rpc_url);
+                }
+                return std::nullopt;
+            }
+            return info;
+        }
+        
+        const json& account = (*proof)["result"];
+        auto balance = account.contains("balance") ? Uint256::from_hex(string_of(account["balance"])) : std::nullopt;
+        std::string_view nonce = account.contains("nonce") ? string_of(account["nonce"]) : std::string_view();
+        if (!balance || nonce.empty()) {
+            return info;
+        }
+        
+        info.ok = true;
+        info.balance = *balance;
+        info.tx_count = hex_to_uint64(nonce);
+        
+        std::string_view code_hash = account.contains("codeHash") ? string_of(account["codeHash"]) : std::string_view();
+        uint8_t hash[32];
+        if (hex_decode_data(code_hash.data(), code_hash.size(), hash, sizeof(hash)) == sizeof(hash)) {
+            static const uint8_t zero_hash[32] = {0};
+            
+            // Accounts that do not exist yet report a zero codeHash
+            info.code_hash = std::string(code_hash);
+            info.is_contract = std::memcmp(hash, EMPTY_CODE_HASH, sizeof(hash)) != 0 &&
+                               std::memcmp(hash, zero_hash, sizeof(hash)) != 0;
+        }
+        
+        if (keep_proof && account.contains("accountProof") && account["accountProof"].is_array()) {
+            info.account_proof = account["accountProof"].get<std::vector<std::string>>();
+        }
     } catch (...) {
         // Parse error
     }
@@ -291,5 +563,62 @@ AddressInfo check_address(const std::string& rpc_url, const std::string& address
     return info;
 }
 
+bool proof_unsupported(const std::string& rpc_url) {
+    std::lock_guard<std::mutex> lock(proof_mutex);
+    return no_proof_endpoints.count(rpc_url) > 0;
+}
+
+AddressInfo check_address(const std::string& rpc_url, const std::string& address,
+                          const QueryOptions& options) {
+    if (options.plan == QueryPlan::Proof && !proof_unsupported(rpc_url)) {
+        auto info = check_address_proof(rpc_url, address, options.keep_proof);
+        if (info) {
+            return *info;
+        }
+    }
+    
+    return check_address_batch(rpc_url, address);
+}
+
+std::vector<AddressInfo> check_addresses(const std::string& rpc_url,
+                                         const std::vector<std::string>& addresses) {
+    std::vector<RpcCall> calls;
+    calls.reserve(addresses.size() * 2 + 1);
+    for (const auto& address : addresses) {
+        calls.push_back({"eth_getBalance", json::array({address, "latest"})});
+        calls.push_back({"eth_getTransactionCount", json::array({address, "latest"})});
+    }
+    calls.push_back({"eth_blockNumber", json::array()});
+    
+    auto results = batch_call(rpc_url, calls);
+    if (results.empty()) {
+        return {};
+    }
+    
+    uint64_t block_number = 0;
+    if (results.back() && results.back()->is_string()) {
+        block_number = hex_to_uint64(string_of(*results.back()));
+    }
+    
+    std::vector<AddressInfo> infos(addresses.size());
+    for (size_t i = 0; i < addresses.size(); i++) {
+        const auto& balance = results[2 * i];
+        const auto& nonce = results[2 * i + 1];
+        if (!balance || !balance->is_string()) continue;
+        
+        auto value = Uint256::from_hex(string_of(*balance));
+        if (!value) continue;
+        
+        infos[i].balance = *value;
+        if (nonce && nonce->is_string()) {
+            infos[i].tx_count = hex_to_uint64(string_of(*nonce));
+        }
+        infos[i].block_number = block_number;
+        infos[i].ok = true;
+    }
+    
+    return infos;
+}
+
 } // namespace RpcClient
 
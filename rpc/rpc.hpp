@@ -3,22 +3,60 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <optional>
 #include <vector>
+#include "../include/json.hpp"
+#include "../uint256/uint256.hpp"
 
 /**
  * Address information from RPC queries
  */
 struct AddressInfo {
-    std::string balance_wei;     // Balance in wei (hex string)
-    std::string balance_eth;     // Balance in ETH (human readable)
-    uint64_t tx_count;           // Transaction count (nonce)
-    bool has_token_activity;     // Has ERC20 transfer events
-    bool is_contract;            // Is a contract address
+    bool ok = false;                 // Endpoint returned a balance
+    Uint256 balance;                 // Balance in wei
+    uint64_t tx_count = 0;           // Transaction count (nonce)
+    uint64_t block_number = 0;       // Block the state was read at (0 if unknown)
+    bool has_token_activity = false; // Has ERC20 transfer events
+    bool is_contract = false;        // Is a contract address (only known if code_hash is set)
+    std::string code_hash;           // Account codeHash from eth_getProof (empty if not queried)
+    std::vector<std::string> account_proof;  // Merkle proof nodes (only with keep_proof)
+};
+
+/**
+ * How check_address fetches account state
+ */
+enum class QueryPlan {
+    Batch,  // eth_getBalance + eth_getTransactionCount in one batch request
+    Proof   // eth_getProof: balance, nonce and codeHash in one call,
+            // falls back to Batch on endpoints that do not support it
+};
+
+struct QueryOptions {
+    QueryPlan plan = QueryPlan::Batch;
+    bool keep_proof = false;  // keep accountProof nodes instead of dropping them while parsing
+};
+
+/**
+ * Single call inside a JSON-RPC batch request
+ */
+struct RpcCall {
+    std::string method;
+    nlohmann::json params;
 };
 
 namespace RpcClient {
 
+/**
+ * Send several JSON-RPC calls in one HTTP request
+ * @param rpc_url RPC endpoint URL
+ * @param calls Calls to send, ids are assigned from their position
+ * @return One entry per call in the same order, nullopt where the call failed,
+ *         or an empty vector if the request itself failed
+ */
+std::vector<std::optional<nlohmann::json>> batch_call(const std::string& rpc_url,
+                                                      const std::vector<RpcCall>& calls);
+
 /**
  * Get ETH balance of an address
  * @param rpc_url RPC endpoint URL
@@ -53,19 +91,48 @@ bool has_token_activity(const std::string& rpc_url, const std::string& address);
 bool is_contract(const std::string& rpc_url, const std::string& address);
 
 /**
- * Get address info (balance, tx count)
+ * Get address info (balance, tx count, and contract flag with QueryPlan::Proof)
  * @param rpc_url RPC endpoint URL
  * @param address Ethereum address (0x...)
+ * @param options Query plan and proof handling
  * @return AddressInfo struct with balance and tx count
  */
-AddressInfo check_address(const std::string& rpc_url, const std::string& address);
+AddressInfo check_address(const std::string& rpc_url, const std::string& address,
+                          const QueryOptions& options = QueryOptions());
+
+/**
+ * Get balance and tx count of several addresses in one batch request
+ * Sends eth_getBalance + eth_getTransactionCount per address and one
+ * eth_blockNumber. Entries whose calls failed have ok == false.
+ * @param rpc_url RPC endpoint URL
+ * @param addresses Ethereum addresses (0x...)
+ * @return One AddressInfo per address, or an empty vector if the request failed
+ */
+std::vector<AddressInfo> check_addresses(const std::string& rpc_url,
+                                         const std::vector<std::string>& addresses);
+
+/**
+ * Check if an endpoint is known to reject eth_getProof
+ * @param rpc_url RPC endpoint URL
+ * @return true once the endpoint answered eth_getProof with "method not supported"
+ *         (-32601, or -32600/-32602 saying so); other errors are not remembered
+ */
+bool proof_unsupported(const std::string& rpc_url);
+
+/**
+ * Convert hex quantity string to uint64_t
+ * @param hex Quantity as hex string (e.g., "0x1234")
+ * @return Parsed value, or 0 on error or if wider than 64 bits
+ */
+uint64_t hex_to_uint64(std::string_view hex);
 
 /**
  * Convert wei hex string to ETH decimal string
  * @param wei_hex Wei value as hex string (e.g., "0x1234")
- * @return Human-readable ETH value
+ * @param decimals Decimals of the native currency (default: 18)
+ * @return Human-readable ETH value, or "0" if not a valid quantity
  */
-std::string wei_to_eth(const std::string& wei_hex);
+std::string wei_to_eth(const std::string& wei_hex, int decimals = 18);
 
 } // namespace RpcClient
 
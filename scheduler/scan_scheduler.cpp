@@ -0,0 +1,234 @@
+#include "scan_scheduler.hpp"
+#include "../rpc/rpc.hpp"
+#include "../priority/chain_priority.hpp"
+#include "../metrics/metrics.hpp"
+#include "../trace/trace.hpp"
+#include <algorithm>
+#include <chrono>
+
+ScanScheduler::ScanScheduler(const ScanOptions& options,
+                             AddressDone on_done,
+                             size_t batch_addresses,
+                             size_t max_in_flight)
+    : options_(options),
+      on_done_(std::move(on_done)),
+      batch_addresses_(batch_addresses > 0 ? batch_addresses : 1),
+      max_in_flight_(max_in_flight > 0 ? max_in_flight : 1) {
+    options_.sink = nullptr;
+    chains_ = MultiChainChecker::select_chains(options_, probed_);
+    order_ = ChainPriority::order(chains_);
+    if (options_.top_k > 0 && options_.top_k < order_.size()) {
+        order_.resize(options_.top_k);
+    }
+    pending_.resize(chains_.size());
+    queued_.resize(chains_.size(), false);
+
+    // eth_getProof cannot be batched across addresses by check_addresses
+    if (options_.query.plan == QueryPlan::Proof) {
+        batch_addresses_ = 1;
+    }
+
+    pool_ = MultiChainChecker::pool();
+    size_t threads = std::clamp<size_t>(options_.num_threads, 1, pool_->size());
+    for (size_t i = 0; i < threads; i++) {
+        workers_.push_back(pool_->submit([this] { worker(); }));
+    }
+}
+
+ScanScheduler::~ScanScheduler() {
+    finish();
+}
+
+void ScanScheduler::add(const std::string& address, uint64_t index) {
+    uint64_t id;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        slot_freed_.wait(lock, [&] { return slots_.size() < max_in_flight_; });
+        id = next_slot_++;
+        slots_.emplace(id, Slot{address, index, order_.size(), {}});
+    }
+
+    // Cache lookups are cheap; only the misses become tasks, queued in
+    // priority order
+    std::vector<std::pair<size_t, std::optional<ChainResult>>> answered;
+    std::vector<size_t> misses;
+    for (size_t c : order_) {
+        bool known_empty = false;
+        auto cached = MultiChainChecker::cached_info(*chains_[c], address, options_, known_empty);
+        if (cached) {
+            Metrics::record_chain(chains_[c]->chain_id, 0.0, ChainOutcome::Cached);
+            answered.push_back({c, MultiChainChecker::make_result(*chains_[c], *cached, true, options_)});
+        } else if (options_.offline) {
+            answered.push_back({c, std::nullopt});
+        } else {
+            misses.push_back(c);
+        }
+    }
+
+    std::vector<Slot> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& [chain, result] : answered) {
+            complete_locked(id, std::move(result), done);
+        }
+        if (order_.empty()) {
+            done.push_back(std::move(slots_[id]));
+            slots_.erase(id);
+        }
+        for (size_t c : misses) {
+            pending_[c].push_back(id);
+            if (!queued_[c]) {
+                queued_[c] = true;
+                ready_.push_back(c);
+            }
+        }
+    }
+    work_ready_.notify_all();
+    report(done);
+}
+
+void ScanScheduler::finish() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        slot_freed_.wait(lock, [&] { return slots_.empty(); });
+        stopping_ = true;
+    }
+    work_ready_.notify_all();
+
+    for (auto& worker : workers_) {
+        worker.get();
+    }
+    workers_.clear();
+}
+
+void ScanScheduler::worker() {
+    while (true) {
+        size_t chain;
+        std::vector<uint64_t> batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_ready_.wait(lock, [&] { return stopping_ || !ready_.empty(); });
+            if (ready_.empty()) {
+                return;
+            }
+
+            // Take a batch from the next chain; it goes to the back of the
+            // line if more addresses are waiting for it
+            chain = ready_.front();
+            ready_.pop_front();
+            auto& queue = pending_[chain];
+            while (!queue.empty() && batch.size() < batch_addresses_) {
+                batch.push_back(queue.front());
+                queue.pop_front();
+            }
+            if (queue.empty()) {
+                queued_[chain] = false;
+            } else {
+                ready_.push_back(chain);
+            }
+        }
+
+        run_batch(chain, batch);
+    }
+}
+
+void ScanScheduler::run_batch(size_t chain_index, const std::vector<uint64_t>& batch) {
+    const Chain& chain = *chains_[chain_index];
+    Trace::Span span("batch", "scan", chain.name, {chain.chain_id});
+
+    std::vector<std::string> addresses;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (uint64_t id : batch) {
+            addresses.push_back(slots_.at(id).address);
+        }
+    }
+
+    std::vector<std::optional<ChainResult>> results(batch.size());
+    std::vector<size_t> open(batch.size());
+    for (size_t i = 0; i < open.size(); i++) {
+        open[i] = i;
+    }
+
+    // Walk the endpoints until every address of the batch has an answer
+    auto batch_start = std::chrono::steady_clock::now();
+    bool first = true;
+    for (const auto& rpc_url : chain.rpc_urls) {
+        if (open.empty()) break;
+        if (!EndpointProbe::is_http_endpoint(rpc_url)) continue;
+        if (!first) Metrics::record_retry("fallback");
+        first = false;
+        std::string host = Trace::enabled() ? EndpointProbe::endpoint_host(rpc_url) : "";
+        Trace::Span attempt("attempt", "scan", host, {chain.chain_id});
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<AddressInfo> infos;
+        if (open.size() == 1) {
+            infos.push_back(RpcClient::check_address(rpc_url, addresses[open[0]], options_.query));
+        } else {
+            std::vector<std::string> request;
+            for (size_t i : open) {
+                request.push_back(addresses[i]);
+            }
+            infos = RpcClient::check_addresses(rpc_url, request);
+            if (infos.empty()) continue;
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::vector<size_t> still_open;
+        for (size_t k = 0; k < open.size(); k++) {
+            size_t i = open[k];
+            if (!infos[k].ok) {
+                still_open.push_back(i);
+                continue;
+            }
+            bool has_activity = !infos[k].balance.is_zero() || infos[k].tx_count > 0;
+            ChainPriority::record(chain.chain_id, has_activity, elapsed.count());
+            std::chrono::duration<double> since_start = std::chrono::steady_clock::now() - batch_start;
+            Metrics::record_chain(chain.chain_id, since_start.count(),
+                                  has_activity ? ChainOutcome::Active : ChainOutcome::Empty);
+            MultiChainChecker::record_info(chain, addresses[i], infos[k]);
+            results[i] = MultiChainChecker::make_result(chain, infos[k], false, options_);
+        }
+        open.swap(still_open);
+    }
+    if (!open.empty()) {
+        std::chrono::duration<double> since_start = std::chrono::steady_clock::now() - batch_start;
+        for (size_t k = 0; k < open.size(); k++) {
+            Metrics::record_chain(chain.chain_id, since_start.count(), ChainOutcome::Failed);
+        }
+    }
+
+    std::vector<Slot> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < batch.size(); i++) {
+            complete_locked(batch[i], std::move(results[i]), done);
+        }
+    }
+    report(done);
+}
+
+void ScanScheduler::complete_locked(uint64_t slot_id, std::optional<ChainResult> result,
+                                    std::vector<Slot>& done) {
+    auto it = slots_.find(slot_id);
+    Slot& slot = it->second;
+    if (result) {
+        slot.results.push_back(std::move(*result));
+    }
+    if (--slot.remaining == 0) {
+        done.push_back(std::move(slot));
+        slots_.erase(it);
+        slot_freed_.notify_all();
+    }
+}
+
+void ScanScheduler::report(std::vector<Slot>& done) {
+    for (auto& slot : done) {
+        std::sort(slot.results.begin(), slot.results.end(),
+                  [](const ChainResult& a, const ChainResult& b) {
+                      return a.chain_id < b.chain_id;
+                  });
+        on_done_(slot.address, slot.index, slot.results);
+    }
+}
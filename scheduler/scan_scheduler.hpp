@@ -0,0 +1,118 @@
+#ifndef SCAN_SCHEDULER_HPP
+#define SCAN_SCHEDULER_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../multi_checker/multi_checker.hpp"
+#include "../pool/worker_pool.hpp"
+
+/**
+ * Scans many addresses as one address x chain matrix
+ *
+ * Every (address, chain) pair that the caches cannot answer becomes a
+ * task in its chain's queue. Chains enter the rotation in ChainPriority
+ * order; workers take them round-robin and pull up to batch_addresses
+ * pending addresses of a chain at once, which go to the endpoint as one
+ * JSON-RPC batch. All worker threads stay busy
+ * until the last pair of the last address is done, instead of idling at
+ * the tail of each address. An address is reported as soon as its last
+ * chain completes.
+ *
+ * The workers are loops submitted to the shared pool; they hold their
+ * pool threads until finish().
+ */
+class ScanScheduler {
+public:
+    /**
+     * Called once per address, from a worker thread (or from add() when
+     * the caches answered every chain), with results sorted by chain ID
+     */
+    using AddressDone = std::function<void(const std::string& address,
+                                           uint64_t index,
+                                           std::vector<ChainResult>& results)>;
+
+    static constexpr size_t DEFAULT_BATCH_ADDRESSES = 8;
+    static constexpr size_t DEFAULT_MAX_IN_FLIGHT = 64;
+
+    /**
+     * Select the chains and start the workers on the shared pool
+     * @param options Scan options (num_threads workers; sink is ignored)
+     * @param on_done Per-address completion callback
+     * @param batch_addresses Addresses per endpoint request (Batch plan only)
+     * @param max_in_flight Addresses admitted before add() blocks
+     */
+    ScanScheduler(const ScanOptions& options,
+                  AddressDone on_done,
+                  size_t batch_addresses = DEFAULT_BATCH_ADDRESSES,
+                  size_t max_in_flight = DEFAULT_MAX_IN_FLIGHT);
+    ~ScanScheduler();
+
+    ScanScheduler(const ScanScheduler&) = delete;
+    ScanScheduler& operator=(const ScanScheduler&) = delete;
+
+    /**
+     * Queue an address on every chain
+     * Blocks while max_in_flight addresses are still being scanned.
+     */
+    void add(const std::string& address, uint64_t index);
+
+    /**
+     * Wait for every queued address to complete and stop the workers
+     */
+    void finish();
+
+    /**
+     * Number of chains each address is scanned on (the top_k best with top_k)
+     */
+    size_t chain_count() const { return order_.size(); }
+
+    /**
+     * Addresses sent per endpoint request
+     */
+    size_t batch_addresses() const { return batch_addresses_; }
+
+private:
+    struct Slot {
+        std::string address;
+        uint64_t index;
+        size_t remaining;
+        std::vector<ChainResult> results;
+    };
+
+    void worker();
+    void run_batch(size_t chain, const std::vector<uint64_t>& slots);
+    void complete_locked(uint64_t slot_id, std::optional<ChainResult> result,
+                         std::vector<Slot>& done);
+    void report(std::vector<Slot>& done);
+
+    ScanOptions options_;
+    AddressDone on_done_;
+    size_t batch_addresses_;
+    size_t max_in_flight_;
+
+    std::vector<Chain> probed_;
+    std::vector<const Chain*> chains_;
+    std::vector<size_t> order_;                     // chain positions, highest priority first
+
+    std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::condition_variable slot_freed_;
+    std::unordered_map<uint64_t, Slot> slots_;
+    uint64_t next_slot_ = 0;
+    std::vector<std::deque<uint64_t>> pending_;     // per chain: slots waiting for it
+    std::deque<size_t> ready_;                      // chains with pending slots, round-robin
+    std::vector<bool> queued_;                      // chain is in ready_
+    bool stopping_ = false;
+    std::shared_ptr<WorkerPool> pool_;
+    std::vector<std::future<void>> workers_;
+};
+
+#endif // SCAN_SCHEDULER_HPP
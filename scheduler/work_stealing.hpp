@@ -0,0 +1,142 @@
+#ifndef WORK_STEALING_HPP
+#define WORK_STEALING_HPP
+
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+/**
+ * One task deque per worker, with stealing
+ * A worker takes tasks from the front of its own deque. Once it runs dry
+ * it steals from the back of the fullest other deque, so the victim keeps
+ * the tasks it is about to run and an idle worker picks up what a slow
+ * one would reach last. All tasks are pushed before the workers start.
+ *
+ * With steal_front, thieves take the victim's front instead: when tasks
+ * must finish roughly in order (an ordered sink with a bounded reorder
+ * window), the back is the task furthest from being accepted.
+ *
+ * pop_lowest() serves a thread without a deque of its own: it takes the
+ * smallest task at the front of any deque.
+ */
+template <typename T>
+class WorkStealingDeques {
+public:
+    explicit WorkStealingDeques(size_t workers, bool steal_front = false)
+        : lanes_(workers > 0 ? workers : 1), steal_front_(steal_front) {}
+
+    size_t workers() const { return lanes_.size(); }
+
+    /**
+     * Append a task to a worker's deque
+     */
+    void push(size_t worker, T task) {
+        Lane& lane = lanes_[worker % lanes_.size()];
+        std::lock_guard<std::mutex> lock(lane.mutex);
+        lane.tasks.push_back(std::move(task));
+    }
+
+    /**
+     * Tasks currently queued for a worker
+     */
+    size_t size(size_t worker) {
+        Lane& lane = lanes_[worker % lanes_.size()];
+        std::lock_guard<std::mutex> lock(lane.mutex);
+        return lane.tasks.size();
+    }
+
+    /**
+     * Next task for a worker: its own front, else a stolen back (or front)
+     * @param stolen Set when the task came from another worker (optional)
+     * @return nullopt once every deque is empty
+     */
+    std::optional<T> pop(size_t worker, bool* stolen = nullptr) {
+        worker %= lanes_.size();
+        {
+            Lane& own = lanes_[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                T task = std::move(own.tasks.front());
+                own.tasks.pop_front();
+                if (stolen) *stolen = false;
+                return task;
+            }
+        }
+
+        while (true) {
+            // Pick the fullest victim; sizes are read without holding all
+            // locks, so retry if it emptied in the meantime
+            size_t victim = lanes_.size();
+            size_t most = 0;
+            for (size_t i = 0; i < lanes_.size(); i++) {
+                if (i == worker) continue;
+                size_t n = size(i);
+                if (n > most) {
+                    most = n;
+                    victim = i;
+                }
+            }
+            if (victim == lanes_.size()) {
+                return std::nullopt;
+            }
+
+            Lane& lane = lanes_[victim];
+            std::lock_guard<std::mutex> lock(lane.mutex);
+            if (!lane.tasks.empty()) {
+                T task;
+                if (steal_front_) {
+                    task = std::move(lane.tasks.front());
+                    lane.tasks.pop_front();
+                } else {
+                    task = std::move(lane.tasks.back());
+                    lane.tasks.pop_back();
+                }
+                if (stolen) *stolen = true;
+                return task;
+            }
+        }
+    }
+
+    /**
+     * Smallest task among the fronts of all deques
+     * With every deque in ascending order, this is the smallest queued task.
+     * @return nullopt once every deque is empty
+     */
+    std::optional<T> pop_lowest() {
+        while (true) {
+            size_t best = lanes_.size();
+            std::optional<T> lowest;
+            for (size_t i = 0; i < lanes_.size(); i++) {
+                std::lock_guard<std::mutex> lock(lanes_[i].mutex);
+                if (!lanes_[i].tasks.empty() && (!lowest || lanes_[i].tasks.front() < *lowest)) {
+                    lowest = lanes_[i].tasks.front();
+                    best = i;
+                }
+            }
+            if (best == lanes_.size()) {
+                return std::nullopt;
+            }
+
+            // Another thread may have taken it in the meantime
+            Lane& lane = lanes_[best];
+            std::lock_guard<std::mutex> lock(lane.mutex);
+            if (!lane.tasks.empty() && !(*lowest < lane.tasks.front()) && !(lane.tasks.front() < *lowest)) {
+                T task = std::move(lane.tasks.front());
+                lane.tasks.pop_front();
+                return task;
+            }
+        }
+    }
+
+private:
+    struct Lane {
+        std::mutex mutex;
+        std::deque<T> tasks;
+    };
+
+    std::vector<Lane> lanes_;
+    bool steal_front_;
+};
+
+#endif // WORK_STEALING_HPP
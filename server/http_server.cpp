@@ -0,0 +1,377 @@
+#include "http_server.hpp"
+#include "../address/address.hpp"
+#include "../chain/chain.hpp"
+#include "../metrics/metrics.hpp"
+#include "../multi_checker/multi_checker.hpp"
+#include "../output/result_sink.hpp"
+#include "../pool/worker_pool.hpp"
+#include "../priority/chain_priority.hpp"
+#include "../rpc/rpc.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+namespace {
+
+constexpr size_t MAX_REQUEST_HEAD = 16 * 1024;
+
+volatile std::sig_atomic_t stop_requested = 0;
+
+void on_signal(int) {
+    stop_requested = 1;
+}
+
+struct Request {
+    std::string method;
+    std::string path;
+    std::map<std::string, std::string> params;
+};
+
+bool send_all(int fd, const std::string& data) {
+    const char* p = data.data();
+    size_t len = data.size();
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+std::string url_decode(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '+') {
+            out += ' ';
+        } else if (s[i] == '%' && i + 2 < s.size() && hex_value(s[i + 1]) >= 0 && hex_value(s[i + 2]) >= 0) {
+            out += static_cast<char>(hex_value(s[i + 1]) * 16 + hex_value(s[i + 2]));
+            i += 2;
+        } else {
+            out += s[i];
+        }
+    }
+    return out;
+}
+
+bool read_request(int fd, Request& request) {
+    std::string head;
+    char buf[4096];
+    while (head.find("\r\n\r\n") == std::string::npos) {
+        if (head.size() > MAX_REQUEST_HEAD) return false;
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        head.append(buf, static_cast<size_t>(n));
+    }
+
+    // Request line: METHOD SP target SP version
+    size_t line_end = head.find("\r\n");
+    std::string line = head.substr(0, line_end);
+    size_t sp1 = line.find(' ');
+    size_t sp2 = line.find(' ', sp1 + 1);
+    if (sp1 == std::string::npos || sp2 == std::string::npos) return false;
+
+    request.method = line.substr(0, sp1);
+    std::string target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+
+    size_t q = target.find('?');
+    request.path = target.substr(0, q);
+    if (q != std::string::npos) {
+        std::string query = target.substr(q + 1);
+        size_t pos = 0;
+        while (pos <= query.size()) {
+            size_t amp = query.find('&', pos);
+            if (amp == std::string::npos) amp = query.size();
+            std::string pair = query.substr(pos, amp - pos);
+            size_t eq = pair.find('=');
+            if (!pair.empty()) {
+                request.params[url_decode(pair.substr(0, eq))] =
+                    eq == std::string::npos ? "" : url_decode(pair.substr(eq + 1));
+            }
+            pos = amp + 1;
+        }
+    }
+    return true;
+}
+
+std::string param(const Request& request, const std::string& name) {
+    auto it = request.params.find(name);
+    return it == request.params.end() ? "" : it->second;
+}
+
+// Flags accept 1/true/yes; a missing flag keeps the default
+bool flag(const Request& request, const std::string& name, bool fallback) {
+    auto it = request.params.find(name);
+    if (it == request.params.end()) return fallback;
+    return it->second == "1" || it->second == "true" || it->second == "yes" || it->second.empty();
+}
+
+void send_json(int fd, int status, const char* reason, const json& body) {
+    std::string payload = body.dump() + "\n";
+    std::string response = "HTTP/1.1 " + std::to_string(status) + " " + reason + "\r\n"
+                           "Content-Type: application/json\r\n"
+                           "Content-Length: " + std::to_string(payload.size()) + "\r\n"
+                           "Connection: close\r\n\r\n" + payload;
+    send_all(fd, response);
+}
+
+void send_error(int fd, int status, const char* reason, const std::string& message) {
+    send_json(fd, status, reason, json{{"error", message}});
+}
+
+void handle_metrics(int fd) {
+    std::ostringstream text;
+    Metrics::write_prometheus(text);
+    std::string payload = text.str();
+    std::string response = "HTTP/1.1 200 OK\r\n"
+                           "Content-Type: text/plain; version=0.0.4\r\n"
+                           "Content-Length: " + std::to_string(payload.size()) + "\r\n"
+                           "Connection: close\r\n\r\n" + payload;
+    send_all(fd, response);
+}
+
+void handle_scan(int fd, const Request& request, const HttpServerOptions& options) {
+    std::string address = param(request, "address");
+    if (!Address::is_valid(address)) {
+        send_error(fd, 400, "Bad Request", "Invalid address format");
+        return;
+    }
+
+    ScanOptions scan;
+    scan.include_testnets = flag(request, "testnets", true);
+    scan.only_with_activity = !flag(request, "all", false);
+    scan.offline = flag(request, "offline", false);
+    scan.skip_empty = flag(request, "skip_empty", false);
+    scan.query.plan = flag(request, "proof", false) ? QueryPlan::Proof : QueryPlan::Batch;
+    scan.num_threads = options.default_threads;
+    scan.verbose = false;
+
+    std::string threads = param(request, "threads");
+    if (!threads.empty()) {
+        try {
+            scan.num_threads = std::clamp<size_t>(std::stoull(threads), 1, options.max_threads);
+        } catch (...) {
+            send_error(fd, 400, "Bad Request", "Invalid thread count");
+            return;
+        }
+    }
+
+    std::string top_k = param(request, "top_k");
+    if (!top_k.empty()) {
+        try {
+            scan.top_k = std::stoull(top_k);
+        } catch (...) {
+            send_error(fd, 400, "Bad Request", "Invalid top_k");
+            return;
+        }
+    }
+
+    if (!send_all(fd, "HTTP/1.1 200 OK\r\n"
+                      "Content-Type: application/x-ndjson\r\n"
+                      "Transfer-Encoding: chunked\r\n"
+                      "Connection: close\r\n\r\n")) {
+        return;
+    }
+
+    // Lines go out in HTTP chunks as chains complete
+    BufferedWriter out(fd, true);
+    NdjsonSink ndjson(out);
+    OrderedSink ordered(ndjson);
+    scan.sink = flag(request, "ordered", false) ? static_cast<ResultSink*>(&ordered) : &ndjson;
+
+    auto start = std::chrono::steady_clock::now();
+    MultiChainChecker::scan_all(address, scan);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    json summary = {{"done", true}, {"results", ndjson.count()}, {"elapsed_ms", elapsed}};
+    out.write(summary.dump() + "\n");
+    out.close();
+}
+
+void handle_info(int fd, const Request& request) {
+    std::string address = param(request, "address");
+    if (!Address::is_valid(address)) {
+        send_error(fd, 400, "Bad Request", "Invalid address format");
+        return;
+    }
+
+    uint64_t chain_id = 0;
+    try {
+        chain_id = std::stoull(param(request, "chain"));
+    } catch (...) {
+        send_error(fd, 400, "Bad Request", "Invalid chain ID");
+        return;
+    }
+
+    auto chain = ChainRegistry::get_by_id(chain_id);
+    if (!chain) {
+        send_error(fd, 404, "Not Found", "Chain ID " + std::to_string(chain_id) + " not found");
+        return;
+    }
+
+    QueryOptions query;
+    query.plan = flag(request, "proof", false) ? QueryPlan::Proof : QueryPlan::Batch;
+
+    for (const auto& rpc_url : chain->rpc_urls) {
+        if (!EndpointProbe::is_http_endpoint(rpc_url)) continue;
+
+        AddressInfo info = RpcClient::check_address(rpc_url, address, query);
+        if (!info.ok) continue;
+
+        json body = {
+            {"chain_id", chain->chain_id},
+            {"chain", chain->name},
+            {"symbol", chain->symbol},
+            {"balance", info.balance.format_units(chain->decimals)},
+            {"balance_wei", info.balance.to_decimal()},
+            {"tx_count", info.tx_count},
+            {"block", info.block_number},
+        };
+        if (!info.code_hash.empty()) {
+            body["is_contract"] = info.is_contract;
+        }
+        send_json(fd, 200, "OK", body);
+        return;
+    }
+
+    send_error(fd, 502, "Bad Gateway", "Could not fetch data from RPC endpoints");
+}
+
+void handle_checksum(int fd, const Request& request) {
+    std::string address = param(request, "address");
+    if (!Address::is_valid(address)) {
+        send_json(fd, 200, "OK", json{{"valid", false}});
+        return;
+    }
+
+    send_json(fd, 200, "OK", json{
+        {"valid", true},
+        {"checksum_valid", Address::verify_checksum(address)},
+        {"checksum", Address::to_checksum(address)},
+        {"zero", Address::is_zero(address)},
+    });
+}
+
+void serve_client(int fd, HttpServerOptions options) {
+    Request request;
+    if (!read_request(fd, request)) {
+        send_error(fd, 400, "Bad Request", "Malformed request");
+    } else if (request.method != "GET") {
+        send_error(fd, 405, "Method Not Allowed", "Only GET is supported");
+    } else if (request.path == "/scan") {
+        handle_scan(fd, request, options);
+    } else if (request.path == "/info") {
+        handle_info(fd, request);
+    } else if (request.path == "/checksum") {
+        handle_checksum(fd, request);
+    } else if (request.path == "/metrics") {
+        handle_metrics(fd);
+    } else {
+        send_error(fd, 404, "Not Found", "Unknown endpoint " + request.path);
+    }
+    close(fd);
+}
+
+} // anonymous namespace
+
+namespace HttpServer {
+
+int run(const HttpServerOptions& options) {
+    if (ChainRegistry::count() == 0) {
+        std::cerr << "Error: No chains loaded\n";
+        return 1;
+    }
+
+    if (!ResultCache::open()) {
+        std::cerr << "Warning: Running without the result cache\n";
+    }
+    if (!EmptyFilter::open()) {
+        std::cerr << "Warning: Running without the empty filter\n";
+    }
+
+    ChainPriority::load();
+    Metrics::enable();
+    if (!options.metrics_path.empty()) {
+        Metrics::dump_on_signal(options.metrics_path);
+    }
+    MultiChainChecker::init_pool(options.workers > 0 ? options.workers : options.max_threads);
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(options.port);
+    if (inet_pton(AF_INET, options.bind_address.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "Error: Invalid bind address " << options.bind_address << "\n";
+        return 1;
+    }
+
+    int listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int reuse = 1;
+    if (listen_fd < 0 ||
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+        bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(listen_fd, 128) != 0) {
+        std::cerr << "Error: Cannot listen on " << options.bind_address << ":" << options.port
+                  << ": " << std::strerror(errno) << "\n";
+        if (listen_fd >= 0) close(listen_fd);
+        return 1;
+    }
+
+    struct sigaction sa{};
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    std::cout << "Serving on http://" << options.bind_address << ":" << options.port
+              << " (" << ChainRegistry::count() << " chains, "
+              << MultiChainChecker::pool()->size() << " workers)\n" << std::flush;
+
+    while (!stop_requested) {
+        pollfd pfd{listen_fd, POLLIN, 0};
+        if (poll(&pfd, 1, 500) <= 0) {
+            continue;
+        }
+
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        std::thread(serve_client, fd, options).detach();
+    }
+
+    std::cout << "\nShutting down\n";
+    close(listen_fd);
+    ChainPriority::save();
+    if (!options.metrics_path.empty()) {
+        Metrics::write_file(options.metrics_path);
+    }
+
+    // Client threads may still be scanning, so the cache mappings and the
+    // worker pool are left to go away with the process
+    return 0;
+}
+
+} // namespace HttpServer
@@ -0,0 +1,47 @@
+#ifndef HTTP_SERVER_HPP
+#define HTTP_SERVER_HPP
+
+#include <cstdint>
+#include <string>
+
+/**
+ * HTTP server settings
+ */
+struct HttpServerOptions {
+    std::string bind_address = "127.0.0.1";
+    uint16_t port = 8080;
+    size_t default_threads = 20;        // scan threads when a request does not ask for a count
+    size_t max_threads = 50;            // upper bound on scan threads per request
+    size_t workers = 0;                 // worker pool shared by all requests (0: max_threads)
+    std::string metrics_path;           // Prometheus file written on SIGUSR1 and at exit (empty: none)
+};
+
+/**
+ * Local HTTP/JSON API over the scanner
+ *
+ *   GET /scan?address=0x..[&threads=N][&testnets=0][&all=1][&proof=1][&offline=1][&skip_empty=1][&ordered=1]
+ *                [&top_k=N]
+ *       Chunked NDJSON: one object per chain as it completes (in chain ID
+ *       order with ordered=1), then a summary line; top_k=N stops after
+ *       the N highest-priority chains
+ *   GET /info?address=0x..&chain=<id>[&proof=1]
+ *       Balance and nonce on one chain
+ *   GET /checksum?address=0x..
+ *       Format and EIP-55 checksum validation
+ *   GET /metrics
+ *       Request phase and chain scan histograms, Prometheus text format
+ *
+ * Each connection is served by its own thread and closed after the response.
+ */
+namespace HttpServer {
+
+/**
+ * Serve requests until SIGINT or SIGTERM
+ * The chain registry must be initialized.
+ * @return Process exit code
+ */
+int run(const HttpServerOptions& options);
+
+} // namespace HttpServer
+
+#endif // HTTP_SERVER_HPP
@@ -0,0 +1,178 @@
+#include "trace.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct Event {
+    const char* name;
+    const char* category;
+    uint64_t start_us;
+    uint64_t duration_us;
+    Trace::Args args;
+    char label[Trace::LABEL_SIZE];
+};
+
+// Written only by its thread; head counts every event ever recorded
+struct ThreadBuffer {
+    int tid = 0;
+    std::string name;
+    std::vector<Event> events;
+    std::atomic<uint64_t> head{0};
+};
+
+std::atomic<bool> g_enabled{false};
+std::chrono::steady_clock::time_point g_epoch;
+
+// Buffers outlive their threads, so detached threads can still be written
+std::mutex g_buffers_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>> g_buffers;
+
+thread_local ThreadBuffer* t_buffer = nullptr;
+
+ThreadBuffer& thread_buffer() {
+    if (!t_buffer) {
+        auto buffer = std::make_unique<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(g_buffers_mutex);
+        buffer->tid = static_cast<int>(g_buffers.size()) + 1;
+        t_buffer = buffer.get();
+        g_buffers.push_back(std::move(buffer));
+    }
+    return *t_buffer;
+}
+
+void write_escaped(std::ostream& out, std::string_view text) {
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out << escaped;
+        } else {
+            out << c;
+        }
+    }
+}
+
+} // anonymous namespace
+
+namespace Trace {
+
+void enable() {
+    g_epoch = std::chrono::steady_clock::now();
+    g_enabled.store(true, std::memory_order_release);
+}
+
+bool enabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+uint64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - g_epoch).count();
+}
+
+void set_thread_name(const std::string& name) {
+    if (!enabled()) return;
+    ThreadBuffer& buffer = thread_buffer();
+    std::lock_guard<std::mutex> lock(g_buffers_mutex);
+    buffer.name = name;
+}
+
+void record(const char* name, const char* category, uint64_t start_us, uint64_t duration_us,
+            std::string_view label, const Args& args) {
+    if (!enabled()) return;
+    ThreadBuffer& buffer = thread_buffer();
+    uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    if (buffer.events.size() < RING_EVENTS) {
+        buffer.events.emplace_back();
+    }
+    Event& event = buffer.events[head % RING_EVENTS];
+    event.name = name;
+    event.category = category;
+    event.start_us = start_us;
+    event.duration_us = duration_us;
+    event.args = args;
+    size_t length = std::min(label.size(), LABEL_SIZE - 1);
+    std::memcpy(event.label, label.data(), length);
+    event.label[length] = '\0';
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+Span::Span(const char* name, const char* category, std::string_view label, const Args& args)
+    : active_(enabled()), name_(name), category_(category), label_(label), args_(args) {
+    if (active_) {
+        start_us_ = now_us();
+    }
+}
+
+Span::~Span() {
+    if (active_) {
+        record(name_, category_, start_us_, now_us() - start_us_, label_, args_);
+    }
+}
+
+bool write_file(const std::string& path, uint64_t* dropped) {
+    std::string tmp = path + ".tmp";
+    uint64_t lost = 0;
+    {
+        std::ofstream out(tmp);
+        if (!out) return false;
+
+        std::lock_guard<std::mutex> lock(g_buffers_mutex);
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool first = true;
+        auto separator = [&]() {
+            if (!first) out << ",\n";
+            first = false;
+        };
+
+        for (const auto& buffer : g_buffers) {
+            separator();
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"args\":{\"name\":\"";
+            write_escaped(out, buffer->name.empty() ? "thread " + std::to_string(buffer->tid) : buffer->name);
+            out << "\"}}";
+
+            uint64_t head = buffer->head.load(std::memory_order_acquire);
+            uint64_t begin = head > RING_EVENTS ? head - RING_EVENTS : 0;
+            lost += begin;
+            for (uint64_t i = begin; i < head; i++) {
+                const Event& event = buffer->events[i % RING_EVENTS];
+                separator();
+                out << "{\"name\":\"" << event.name;
+                if (event.label[0] != '\0') {
+                    out << " ";
+                    write_escaped(out, event.label);
+                }
+                out << "\",\"cat\":\"" << event.category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+                    << ",\"ts\":" << event.start_us << ",\"dur\":" << event.duration_us << ",\"args\":{";
+                bool first_arg = true;
+                auto arg = [&](const char* key) -> std::ostream& {
+                    out << (first_arg ? "\"" : ",\"") << key << "\":";
+                    first_arg = false;
+                    return out;
+                };
+                if (event.args.chain_id != 0) arg("chain_id") << event.args.chain_id;
+                if (event.args.worker >= 0) arg("worker") << event.args.worker;
+                if (event.args.stolen) arg("stolen") << "true";
+                out << "}}";
+            }
+        }
+        out << "\n]}\n";
+        if (!out) return false;
+    }
+
+    if (dropped) *dropped = lost;
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+} // namespace Trace
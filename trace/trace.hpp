@@ -0,0 +1,88 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * Scan timeline in the Chrome trace-event format (for Perfetto or chrome://tracing)
+ *
+ * Each thread appends complete ("X") events to its own ring buffer, so
+ * recording takes no lock; when a buffer is full the oldest events are
+ * overwritten. Recording is a no-op until enable().
+ */
+namespace Trace {
+
+// Events kept per thread (the buffer grows up to this size)
+constexpr size_t RING_EVENTS = 1 << 16;
+
+// Longest label kept per event, including the terminator (longer ones are cut)
+constexpr size_t LABEL_SIZE = 32;
+
+/**
+ * Start recording; timestamps count from this call
+ */
+void enable();
+
+bool enabled();
+
+/**
+ * Microseconds since enable()
+ */
+uint64_t now_us();
+
+/**
+ * Name the calling thread in the timeline
+ */
+void set_thread_name(const std::string& name);
+
+/**
+ * Optional event details; zero fields are left out of the output
+ */
+struct Args {
+    uint64_t chain_id = 0;
+    int worker = -1;        // scan worker index, -1 for none
+    bool stolen = false;    // chain taken from another worker's deque
+};
+
+/**
+ * Record a finished span on the calling thread
+ * @param name Static string, e.g. "chain" or "dns"
+ * @param category Static string, e.g. "scan" or "request"
+ * @param label Shown after the name (a chain name or endpoint host)
+ */
+void record(const char* name, const char* category, uint64_t start_us, uint64_t duration_us,
+            std::string_view label = {}, const Args& args = {});
+
+/**
+ * Span covering the lifetime of the object
+ */
+class Span {
+public:
+    Span(const char* name, const char* category, std::string_view label = {}, const Args& args = {});
+    ~Span();
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    bool active_;
+    const char* name_;
+    const char* category_;
+    std::string_view label_;
+    Args args_;
+    uint64_t start_us_ = 0;
+};
+
+/**
+ * Write every thread's events as a trace-event JSON file
+ * Call once the traced work is done; buffers are read without locking.
+ * @param dropped Set to the number of events lost to full ring buffers
+ * @return true if the file was written
+ */
+bool write_file(const std::string& path, uint64_t* dropped = nullptr);
+
+} // namespace Trace
+
+#endif // TRACE_HPP
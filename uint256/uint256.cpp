@@ -0,0 +1,115 @@
+#include "uint256.hpp"
+
+extern "C" {
+#include "../hex/hex.h"
+}
+
+// Largest power of ten that fits in 64 bits
+static constexpr uint64_t CHUNK_BASE = 10000000000000000000ULL;  // 10^19
+static constexpr int CHUNK_DIGITS = 19;
+
+// 2^256 - 1 has 78 decimal digits
+static constexpr size_t MAX_DIGITS = 80;
+
+std::optional<Uint256> Uint256::from_hex(std::string_view hex) {
+    Uint256 value;
+    if (!hex_decode_quantity(hex.data(), hex.size(), value.limbs, 4)) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+Uint256& Uint256::operator+=(const Uint256& o) {
+    unsigned __int128 carry = 0;
+    for (int i = 0; i < 4; i++) {
+        carry += static_cast<unsigned __int128>(limbs[i]) + o.limbs[i];
+        limbs[i] = static_cast<uint64_t>(carry);
+        carry >>= 64;
+    }
+    return *this;
+}
+
+Uint256& Uint256::operator-=(const Uint256& o) {
+    uint64_t borrow = 0;
+    for (int i = 0; i < 4; i++) {
+        uint64_t a = limbs[i];
+        uint64_t d = a - o.limbs[i] - borrow;
+        borrow = (a < o.limbs[i] || (a == o.limbs[i] && borrow)) ? 1 : 0;
+        limbs[i] = d;
+    }
+    return *this;
+}
+
+uint64_t Uint256::divmod(uint64_t divisor) {
+    unsigned __int128 rem = 0;
+    for (int i = 3; i >= 0; i--) {
+        unsigned __int128 cur = (rem << 64) | limbs[i];
+        limbs[i] = static_cast<uint64_t>(cur / divisor);
+        rem = cur % divisor;
+    }
+    return static_cast<uint64_t>(rem);
+}
+
+std::string Uint256::to_hex() const {
+    char buf[2 + 64 + 1];
+    size_t pos = sizeof(buf) - 1;
+    buf[pos] = '\0';
+
+    static const char hex_chars[] = "0123456789abcdef";
+    int top = 3;
+    while (top > 0 && limbs[top] == 0) top--;
+
+    // Full 16-digit limbs below the top one, the top limb without padding
+    for (int i = 0; i <= top; i++) {
+        uint64_t limb = limbs[i];
+        for (int d = 0; d < 16 && (i < top || limb != 0 || d == 0); d++) {
+            buf[--pos] = hex_chars[limb & 0x0F];
+            limb >>= 4;
+        }
+    }
+
+    buf[--pos] = 'x';
+    buf[--pos] = '0';
+    return std::string(buf + pos);
+}
+
+std::string Uint256::to_decimal() const {
+    char buf[MAX_DIGITS];
+    size_t pos = sizeof(buf);
+
+    // Peel off 19 digits per division instead of one
+    Uint256 v = *this;
+    do {
+        uint64_t chunk = v.divmod(CHUNK_BASE);
+        bool last = v.is_zero();
+        for (int d = 0; d < CHUNK_DIGITS && (!last || chunk != 0 || d == 0); d++) {
+            buf[--pos] = static_cast<char>('0' + chunk % 10);
+            chunk /= 10;
+        }
+    } while (!v.is_zero());
+
+    return std::string(buf + pos, sizeof(buf) - pos);
+}
+
+std::string Uint256::format_units(int decimals) const {
+    std::string digits = to_decimal();
+    if (decimals <= 0) {
+        return digits;
+    }
+
+    size_t scale = static_cast<size_t>(decimals);
+    if (digits.size() <= scale) {
+        digits.insert(0, scale + 1 - digits.size(), '0');
+    }
+
+    size_t point = digits.size() - scale;
+    size_t end = digits.find_last_not_of('0');
+    if (end == std::string::npos || end < point) {
+        digits.resize(point);  // no fractional part left
+        return digits;
+    }
+
+    digits.resize(end + 1);
+    digits.insert(point, 1, '.');
+    return digits;
+}
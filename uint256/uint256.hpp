@@ -0,0 +1,78 @@
+#ifndef UINT256_HPP
+#define UINT256_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * Fixed-width 256-bit unsigned integer (EVM word)
+ * Stored as four 64-bit limbs, least significant first.
+ */
+struct Uint256 {
+    uint64_t limbs[4] = {0, 0, 0, 0};
+
+    constexpr Uint256() = default;
+    constexpr Uint256(uint64_t value) : limbs{value, 0, 0, 0} {}
+
+    /**
+     * Parse a hex quantity (e.g., "0x1234", prefix optional)
+     * @return Value, or nullopt if empty, not hex, or wider than 256 bits
+     */
+    static std::optional<Uint256> from_hex(std::string_view hex);
+
+    bool is_zero() const { return (limbs[0] | limbs[1] | limbs[2] | limbs[3]) == 0; }
+
+    /**
+     * Lowest 64 bits, and whether the value fits in them
+     */
+    uint64_t low64() const { return limbs[0]; }
+    bool fits_u64() const { return (limbs[1] | limbs[2] | limbs[3]) == 0; }
+
+    /**
+     * Wrapping addition / subtraction (mod 2^256)
+     */
+    Uint256& operator+=(const Uint256& o);
+    Uint256& operator-=(const Uint256& o);
+    friend Uint256 operator+(Uint256 a, const Uint256& b) { return a += b; }
+    friend Uint256 operator-(Uint256 a, const Uint256& b) { return a -= b; }
+
+    /**
+     * Divide in place by a 64-bit divisor
+     * @return Remainder
+     */
+    uint64_t divmod(uint64_t divisor);
+
+    /**
+     * Lowercase hex quantity with 0x prefix and no leading zeros ("0x0" for zero)
+     */
+    std::string to_hex() const;
+
+    /**
+     * Base-10 digits, no leading zeros
+     */
+    std::string to_decimal() const;
+
+    /**
+     * Decimal string scaled down by 10^decimals, trailing fraction zeros trimmed
+     * e.g., 1500000000000000000 with 18 decimals -> "1.5"
+     */
+    std::string format_units(int decimals) const;
+
+    friend int compare(const Uint256& a, const Uint256& b) {
+        for (int i = 3; i >= 0; i--) {
+            if (a.limbs[i] != b.limbs[i]) return a.limbs[i] < b.limbs[i] ? -1 : 1;
+        }
+        return 0;
+    }
+
+    friend bool operator==(const Uint256& a, const Uint256& b) { return compare(a, b) == 0; }
+    friend bool operator!=(const Uint256& a, const Uint256& b) { return compare(a, b) != 0; }
+    friend bool operator<(const Uint256& a, const Uint256& b) { return compare(a, b) < 0; }
+    friend bool operator<=(const Uint256& a, const Uint256& b) { return compare(a, b) <= 0; }
+    friend bool operator>(const Uint256& a, const Uint256& b) { return compare(a, b) > 0; }
+    friend bool operator>=(const Uint256& a, const Uint256& b) { return compare(a, b) >= 0; }
+};
+
+#endif // UINT256_HPP